@@ -0,0 +1,309 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Scenario driver for bench.sh. It talks to the X server dwm-bench manages
+ * and to dwm's IPC socket, runs each scenario with synthetic clients and
+ * prints one JSON object per scenario: wall time, CPU time and resident size
+ * of dwm, and the X requests dwm sent while the scenario ran.
+ *
+ * usage: benchrun pid ipcsocket statsfile
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <X11/keysym.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XTest.h>
+
+#include "util.h"
+
+#define LENGTH(X)               (sizeof X / sizeof X[0])
+#define MAXWINS                 1000
+
+typedef struct {
+	const char *name;
+	void (*run)(int arg);
+	int arg;
+} Scenario;
+
+typedef struct {
+	double wall, cpu;           /* milliseconds */
+	unsigned long requests;
+} Sample;
+
+/* function declarations */
+static void begin(void);
+static void configure(int n);
+static void createwins(int n, Bool fixed);
+static void destroywins(void);
+static void drag(int steps);
+static void ipc(const char *fmt, ...);
+static void map(int n);
+static void sample(Sample *s);
+static void settle(void);
+static void status(int n);
+static void tags(int rounds);
+static void titles(int n);
+
+/* variables */
+static Display *dpy;
+static Window root;
+static Window wins[MAXWINS];
+static int nwins;
+static pid_t pid;
+static int ipcfd;
+static char reply[4096];    /* end of the last ipc() reply */
+static unsigned int ntags;
+static const char *statsfile;
+static Sample start;
+static Bool skipped;
+
+static Scenario scenarios[] = {
+	/* name          function    argument */
+	{ "map10",       map,        10 },
+	{ "map100",      map,        100 },
+	{ "map1000",     map,        1000 },
+	{ "tags",        tags,       100 },
+	{ "titles",      titles,     10000 },
+	{ "configure",   configure,  10000 },
+	{ "drag",        drag,       1000 },
+	{ "status",      status,     200 },
+};
+
+/* function implementations */
+void
+begin(void) {
+	settle();
+	sample(&start);
+}
+
+/* floating clients asking to be moved and resized */
+void
+configure(int n) {
+	int i;
+
+	createwins(20, True);
+	begin();
+	for(i = 0; i < n; i++)
+		XMoveResizeWindow(dpy, wins[i % nwins], 10 + i % 200, 10 + i % 100,
+		                  200 + i % 50, 150 + i % 50);
+}
+
+/* Maps n windows and waits until dwm has mapped all of them. Fixed size
+ * windows end up floating. */
+void
+createwins(int n, Bool fixed) {
+	int i, mapped;
+	XSizeHints h;
+	XEvent ev;
+
+	for(i = 0; i < n && nwins < MAXWINS; i++) {
+		wins[nwins] = XCreateSimpleWindow(dpy, root, 0, 0, 200, 150, 0, 0, 0);
+		XSelectInput(dpy, wins[nwins], StructureNotifyMask);
+		if(fixed) {
+			h.min_width = h.max_width = 200;
+			h.min_height = h.max_height = 150;
+			h.flags = PMinSize | PMaxSize;
+			XSetWMNormalHints(dpy, wins[nwins], &h);
+		}
+		XStoreName(dpy, wins[nwins], "bench");
+		XMapWindow(dpy, wins[nwins++]);
+	}
+	for(mapped = 0; mapped < i; )
+		if(!XNextEvent(dpy, &ev) && ev.type == MapNotify)
+			mapped++;
+}
+
+void
+destroywins(void) {
+	while(nwins > 0)
+		XDestroyWindow(dpy, wins[--nwins]);
+	settle();
+}
+
+/* resizes a floating client with Mod1-Button3 as in the default config.h */
+void
+drag(int steps) {
+	int i, d;
+
+	if(!XTestQueryExtension(dpy, &d, &d, &d, &d)) {
+		skipped = True;
+		return;
+	}
+	createwins(1, False);
+	ipc("togglefloating");
+	begin();
+	XTestFakeMotionEvent(dpy, -1, 100, 100, CurrentTime);
+	XTestFakeKeyEvent(dpy, XKeysymToKeycode(dpy, XK_Alt_L), True, CurrentTime);
+	XTestFakeButtonEvent(dpy, Button3, True, CurrentTime);
+	for(i = 0; i < steps; i++)
+		XTestFakeMotionEvent(dpy, -1, 300 + i % 400, 300 + i % 300, CurrentTime);
+	XTestFakeButtonEvent(dpy, Button3, False, CurrentTime);
+	XTestFakeKeyEvent(dpy, XKeysymToKeycode(dpy, XK_Alt_L), False, CurrentTime);
+}
+
+/* sends a request and waits for its ok, the reply is left in reply */
+void
+ipc(const char *fmt, ...) {
+	char buf[4096];
+	int len, n;
+	va_list ap;
+
+	va_start(ap, fmt);
+	len = vsnprintf(buf, sizeof buf - 1, fmt, ap);
+	va_end(ap);
+	buf[len++] = '\n';
+	if(write(ipcfd, buf, len) != len)
+		die("benchrun: ipc write failed\n");
+	/* the reply ends in ok or err, nothing else is pending on the socket */
+	for(len = 0; ; len += n) {
+		if((n = read(ipcfd, reply + len, sizeof reply - 1 - len)) <= 0)
+			die("benchrun: ipc read failed\n");
+		reply[len + n] = '\0';
+		if(strstr(reply, "ok\n") || strstr(reply, "err "))
+			break;
+		if(len + n >= (int)sizeof reply - 1)
+			len = -n; /* only the end of long replies matters */
+	}
+}
+
+void
+map(int n) {
+	begin();
+	createwins(n, False);
+}
+
+/* dwm's CPU time from /proc and its X requests from the stats file */
+void
+sample(Sample *s) {
+	char buf[1024], *p;
+	unsigned long utime, stime;
+	struct timespec t;
+	FILE *f;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	s->wall = t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+	snprintf(buf, sizeof buf, "/proc/%d/stat", (int)pid);
+	if(!(f = fopen(buf, "r")) || !fgets(buf, sizeof buf, f)
+	|| !(p = strrchr(buf, ')'))
+	|| sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+		die("benchrun: cannot read /proc/%d/stat\n", (int)pid);
+	fclose(f);
+	s->cpu = (utime + stime) * 1000.0 / sysconf(_SC_CLK_TCK);
+	ipc("stats");
+	if(!(f = fopen(statsfile, "r")) || fscanf(f, "X requests %lu", &s->requests) != 1)
+		die("benchrun: cannot read %s\n", statsfile);
+	fclose(f);
+}
+
+/* Returns once dwm has handled everything sent so far. dwm polls its IPC
+ * connections before draining X events, so the first request may be
+ * answered early, the second is not answered before the events are done. */
+void
+settle(void) {
+	XSync(dpy, False);
+	ipc("monitors");
+	ipc("monitors");
+}
+
+/* status text updates at 100 Hz */
+void
+status(int n) {
+	char buf[32];
+	int i;
+
+	begin();
+	for(i = 0; i < n; i++) {
+		snprintf(buf, sizeof buf, "bench %d", i);
+		XStoreName(dpy, root, buf);
+		XFlush(dpy);
+		usleep(10000);
+	}
+}
+
+void
+tags(int rounds) {
+	int i;
+
+	createwins(20, False);
+	begin();
+	for(i = 0; i < rounds * (int)ntags; i++)
+		ipc("view %u", 1 << (i % ntags));
+}
+
+void
+titles(int n) {
+	char buf[32];
+	int i;
+
+	createwins(20, False);
+	begin();
+	for(i = 0; i < n; i++) {
+		snprintf(buf, sizeof buf, "title %d", i);
+		XStoreName(dpy, wins[i % nwins], buf);
+	}
+}
+
+int
+main(int argc, char *argv[]) {
+	struct sockaddr_un addr;
+	unsigned int i, tagmask;
+	long rss = 0;
+	char buf[256];
+	Sample end;
+	FILE *f;
+
+	if(argc != 4)
+		die("usage: benchrun pid ipcsocket statsfile\n");
+	pid = atoi(argv[1]);
+	statsfile = argv[3];
+	if(!(dpy = XOpenDisplay(NULL)))
+		die("benchrun: cannot open display\n");
+	root = DefaultRootWindow(dpy);
+	memset(&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, argv[2], sizeof addr.sun_path - 1);
+	if((ipcfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+	|| connect(ipcfd, (struct sockaddr *)&addr, sizeof addr) < 0)
+		die("benchrun: cannot connect to %s\n", argv[2]);
+	/* dwm starts with no tag in view; with all of them in view the
+	 * monitors reply carries the mask of every tag there is */
+	ipc("view %u", ~0u);
+	ipc("monitors");
+	if(sscanf(reply, "monitor %*d %*d %*d %*d %*d %u", &tagmask) != 1 || !tagmask)
+		die("benchrun: cannot read the tags from %s\n", argv[2]);
+	for(ntags = 0; tagmask; tagmask >>= 1)
+		ntags++;
+	for(i = 0; i < LENGTH(scenarios); i++) {
+		skipped = False;
+		scenarios[i].run(scenarios[i].arg);
+		if(skipped) {
+			printf("{\"scenario\":\"%s\",\"skipped\":true}\n", scenarios[i].name);
+			destroywins();
+			continue;
+		}
+		settle();
+		sample(&end);
+		snprintf(buf, sizeof buf, "/proc/%d/status", (int)pid);
+		if((f = fopen(buf, "r"))) {
+			while(fgets(buf, sizeof buf, f))
+				if(sscanf(buf, "VmRSS: %ld", &rss) == 1)
+					break;
+			fclose(f);
+		}
+		printf("{\"scenario\":\"%s\",\"wall_ms\":%.1f,\"cpu_ms\":%.1f,"
+		       "\"rss_kb\":%ld,\"requests\":%lu}\n", scenarios[i].name,
+		       end.wall - start.wall, end.cpu - start.cpu, rss,
+		       end.requests - start.requests);
+		fflush(stdout);
+		destroywins();
+	}
+	XCloseDisplay(dpy);
+	return EXIT_SUCCESS;
+}
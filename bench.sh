@@ -0,0 +1,31 @@
+#!/bin/sh
+# Runs dwm-bench on a private Xvfb and prints one JSON line per scenario,
+# see bench.c, or replays a capture and prints dwm's statistics for it, see
+# replay.c. Usage: ./bench.sh [-r capture] [display number]
+if [ "$1" = -r ]; then
+	capture=$2
+	shift 2
+fi
+n=${1:-99}
+export DISPLAY=:$n
+
+Xvfb :$n -screen 0 1920x1080x24 -nolisten tcp 2>/dev/null &
+xpid=$!
+trap 'kill $dpid $xpid 2>/dev/null' EXIT INT TERM
+while [ ! -S /tmp/.X11-unix/X$n ]; do
+	kill -0 $xpid 2>/dev/null || { echo "bench: Xvfb failed" >&2; exit 1; }
+	sleep 0.1
+done
+
+./dwm-bench &
+dpid=$!
+while [ ! -S /tmp/dwm-$n.sock ]; do
+	kill -0 $dpid 2>/dev/null || { echo "bench: dwm failed" >&2; exit 1; }
+	sleep 0.1
+done
+
+if [ -n "$capture" ]; then
+	./replay -f "$capture" /tmp/dwm-$n.sock && cat /tmp/dwm-$n.stats
+else
+	./benchrun $dpid /tmp/dwm-$n.sock /tmp/dwm-$n.stats
+fi
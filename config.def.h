@@ -10,6 +10,7 @@ static const char selbgcolor[]      = "#005577";
 static const char selfgcolor[]      = "#eeeeee";
 static const unsigned int borderpx  = 1;        /* border pixel of windows */
 static const unsigned int snap      = 32;       /* snap pixel */
+static const unsigned int refreshrate = 60;     /* mouse move/resize updates per second, 0 for no limit */
 static const Bool showbar           = True;     /* False means no bar */
 static const Bool topbar            = True;     /* False means bottom bar */
 
@@ -30,6 +31,7 @@ static const Rule rules[] = {
 static const float mfact      = 0.55; /* factor of master area size [0.05..0.95] */
 static const int nmaster      = 1;    /* number of clients in master area */
 static const Bool resizehints = True; /* True means respect size hints in tiled resizals */
+static const Bool lazymonocle = False; /* True means monocle only resizes the client on top */
 
 static const Layout layouts[] = {
 	/* symbol     arrange function */
@@ -107,3 +109,39 @@ static Button buttons[] = {
 	{ ClkTagBar,            MODKEY,         Button3,        toggletag,      {0} },
 };
 
+/* IPC, see dwm(1), %s is replaced by the display number */
+static const char ipcsocket[] = "/tmp/dwm-%s.sock";
+
+static Command commands[] = {
+	/* name             function        argument */
+	{ "view",           view,           ArgUint },
+	{ "toggleview",     toggleview,     ArgUint },
+	{ "tag",            tag,            ArgUint },
+	{ "toggletag",      toggletag,      ArgUint },
+	{ "focusstack",     focusstack,     ArgInt },
+	{ "focusmon",       focusmon,       ArgInt },
+	{ "tagmon",         tagmon,         ArgInt },
+	{ "incnmaster",     incnmaster,     ArgInt },
+	{ "setmfact",       setmfact,       ArgFloat },
+	{ "setcfact",       setcfact,       ArgFloat },
+	{ "setlayout",      setlayout,      ArgLayout },
+	{ "togglebar",      togglebar,      ArgNone },
+	{ "togglefloating", togglefloating, ArgNone },
+	{ "zoom",           zoom,           ArgNone },
+	{ "pushup",         pushup,         ArgNone },
+	{ "pushdown",       pushdown,       ArgNone },
+	{ "killclient",     killclient,     ArgNone },
+	{ "spawn",          spawn,          ArgShell },
+	{ "quit",           quit,           ArgNone },
+};
+
+/* shared memory state snapshot, see state.h */
+static const char statefile[] = "/dev/shm/dwm-%s";
+
+/* instrumentation output, written on SIGUSR1 and at exit, see config.mk */
+#ifdef STATS
+static const char statsfile[] = "/tmp/dwm-%s.stats";
+#endif /* STATS */
+#ifdef TRACE
+static const char tracefile[] = "/tmp/dwm-%s.trace.json";
+#endif /* TRACE */
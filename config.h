@@ -21,11 +21,13 @@ static const char urgbgcolor[]           = "#181B20";
 static const char urgfgcolor[]           = "#744B40";
 static const unsigned int borderpx       = 2;
 static const unsigned int snap           = 2;
+static const unsigned int refreshrate    = 60;
 static const float mfact                 = 0.63;
 static const int nmaster                 = 1;
 static const Bool showbar                = True;
 static const Bool topbar                 = False;
 static const Bool resizehints            = False;
+static const Bool lazymonocle            = True;
 
 static const char *tags[] = { "web", "skype", "term", "code", "media", "doc", "n/a" };
 
@@ -144,3 +146,40 @@ static Button buttons[] = {
 	{ ClkTagBar,            MODKEY,         Button1,        tag,            {0} },
 	{ ClkTagBar,            MODKEY,         Button3,        toggletag,      {0} },
 };
+
+/* IPC, see dwm(1), %s is replaced by the display number */
+static const char ipcsocket[] = "/tmp/dwm-%s.sock";
+
+static Command commands[] = {
+	/* name             function        argument */
+	{ "view",           view,           ArgUint },
+	{ "toggleview",     toggleview,     ArgUint },
+	{ "tag",            tag,            ArgUint },
+	{ "toggletag",      toggletag,      ArgUint },
+	{ "focusstack",     focusstack,     ArgInt },
+	{ "focusmon",       focusmon,       ArgInt },
+	{ "tagmon",         tagmon,         ArgInt },
+	{ "incnmaster",     incnmaster,     ArgInt },
+	{ "setmfact",       setmfact,       ArgFloat },
+	{ "setcfact",       setcfact,       ArgFloat },
+	{ "setlayout",      setlayout,      ArgLayout },
+	{ "togglebar",      togglebar,      ArgNone },
+	{ "togglefloating", togglefloating, ArgNone },
+	{ "zoom",           zoom,           ArgNone },
+	{ "pushup",         pushup,         ArgNone },
+	{ "pushdown",       pushdown,       ArgNone },
+	{ "killclient",     killclient,     ArgNone },
+	{ "spawn",          spawn,          ArgShell },
+	{ "quit",           quit,           ArgNone },
+};
+
+/* shared memory state snapshot, see state.h */
+static const char statefile[] = "/dev/shm/dwm-%s";
+
+/* instrumentation output, written on SIGUSR1 and at exit, see config.mk */
+#ifdef STATS
+static const char statsfile[] = "/tmp/dwm-%s.stats";
+#endif /* STATS */
+#ifdef TRACE
+static const char tracefile[] = "/tmp/dwm-%s.trace.json";
+#endif /* TRACE */
@@ -14,15 +14,28 @@ X11LIB = /usr/X11R6/lib
 XINERAMALIBS  = -lXinerama
 XINERAMAFLAGS = -DXINERAMA
 
+# XRandR, comment if you don't want it
+XRANDRLIBS  = -lXrandr
+XRANDRFLAGS = -DXRANDR
+
+# statistics and tracing, uncomment to measure handlers and X traffic
+# (see stats.h)
+#STATSFLAGS = -DSTATS
+#STATSFLAGS = -DSTATS -DTRACE
+
 # includes and libs
-INCS = -I${X11INC} `pkg-config --cflags xft pangoxft`
-LIBS = -L${X11LIB} -lX11 ${XINERAMALIBS} `pkg-config --libs xft pangoxft`
+INCS = -I${X11INC} `pkg-config --cflags xft fontconfig pangoxft`
+LIBS = -L${X11LIB} -lX11 -lXext ${XINERAMALIBS} ${XRANDRLIBS} `pkg-config --libs xft fontconfig pangoxft` -lpthread
 
 # flags
-CPPFLAGS = -D_BSD_SOURCE -D_POSIX_C_SOURCE=2 -DVERSION=\"${VERSION}\" ${XINERAMAFLAGS}
+CPPFLAGS = -D_BSD_SOURCE -D_POSIX_C_SOURCE=200112L -DVERSION=\"${VERSION}\" ${XINERAMAFLAGS} ${XRANDRFLAGS} ${STATSFLAGS}
 #CFLAGS   = -g -std=c99 -pedantic -Wall -O0 ${INCS} ${CPPFLAGS}
 CFLAGS   = -std=c99 -pedantic -Wall -Os ${INCS} ${CPPFLAGS}
 LDFLAGS  = -s ${LIBS}
 
+# dwm-mock runs on the fake Xlib of mockx.c, without Xinerama and RandR but
+# with the statistics chosen above
+MOCKFLAGS = -std=c99 -pedantic -Wall -O2 ${INCS} -D_BSD_SOURCE -D_POSIX_C_SOURCE=200112L -DVERSION=\"${VERSION}\" ${STATSFLAGS}
+
 # compiler and linker
 CC = cc
@@ -1,14 +1,29 @@
 /* See LICENSE file for copyright and license details. */
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <X11/Xlib.h>
 #include <X11/Xft/Xft.h>
+#include <fontconfig/fontconfig.h>
 #include <pango/pangoxft.h>
 
 #include "drw.h"
+#include "stats.h"
 #include "util.h"
 
+#if defined(STATS) || defined(TRACE)
+Stat drwstats[DrwLast] = {
+	[DrwRender] = { "pango render" },
+	[DrwExtents] = { "pango extents" }
+};
+#endif /* STATS || TRACE */
+
+static pthread_t preloader;
+static int preloadfds[2] = { -1, -1 };
+
 Drw *
 drw_create(Display *dpy, int screen, Window root, unsigned int w, unsigned int h) {
 	Drw *drw = (Drw *)calloc(1, sizeof(Drw));
@@ -35,6 +50,8 @@ drw_resize(Drw *drw, unsigned int w, unsigned int h) {
 	if(drw->drawable != 0)
 		XFreePixmap(drw->dpy, drw->drawable);
 	drw->drawable = XCreatePixmap(drw->dpy, drw->root, w, h, DefaultDepth(drw->dpy, drw->screen));
+	/* text would otherwise still be drawn to the freed pixmap */
+	XftDrawChange(drw->xftdrawable, drw->drawable);
 }
 
 void
@@ -74,6 +91,61 @@ drw_font_free(Display *dpy, Fnt *font) {
 	free(font);
 }
 
+/* Cheap estimate of the height drw_font_create() will report, computed from
+ * the font description alone so that it does not touch fontconfig. */
+int
+drw_font_guessh(Display *dpy, int screen, const char *fontname) {
+	PangoFontDescription *desc;
+	double px, dpi = 96.0;
+
+	if(DisplayHeightMM(dpy, screen) > 0)
+		dpi = DisplayHeight(dpy, screen) * 25.4 / DisplayHeightMM(dpy, screen);
+	desc = pango_font_description_from_string(fontname);
+	px = (double)pango_font_description_get_size(desc) / PANGO_SCALE;
+	if(!pango_font_description_get_size_is_absolute(desc))
+		px *= dpi / 72.0;
+	pango_font_description_free(desc);
+	return px > 0 ? (int)(px * 1.2 + 0.5) : 0;
+}
+
+static void *
+preload(void *unused) {
+	/* loading the configuration and font caches is the slow part of
+	 * creating a font, it does not need the X connection */
+	FcInit();
+	if(write(preloadfds[1], "", 1) < 0)
+		perror("dwm: write");
+	return NULL;
+}
+
+/* Starts initializing fontconfig in the background. Returns a descriptor
+ * which becomes readable once drw_font_create() will no longer block on it,
+ * or -1 if the caller has to create the font synchronously. */
+int
+drw_font_preload(void) {
+	if(pipe(preloadfds) < 0)
+		return -1;
+	/* programs spawned meanwhile must not hold the pipe open */
+	fcntl(preloadfds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(preloadfds[1], F_SETFD, FD_CLOEXEC);
+	if(pthread_create(&preloader, NULL, preload, NULL) != 0) {
+		close(preloadfds[0]);
+		close(preloadfds[1]);
+		return preloadfds[0] = preloadfds[1] = -1;
+	}
+	return preloadfds[0];
+}
+
+void
+drw_font_preload_wait(void) {
+	if(preloadfds[0] < 0)
+		return;
+	pthread_join(preloader, NULL);
+	close(preloadfds[0]);
+	close(preloadfds[1]);
+	preloadfds[0] = preloadfds[1] = -1;
+}
+
 Clr *
 drw_clr_create(Drw *drw, const char *clrname) {
 	Clr *clr;
@@ -131,6 +203,7 @@ drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, const char *tex
 	char buf[256];
 	int i, tx, ty, len, olen;
 	Extnts tex;
+	STATSPAN(sp);
 
 	if(!drw || !drw->scheme)
 		return;
@@ -151,8 +224,10 @@ drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, const char *tex
 	if(len < olen)
 		for(i = len; i && i > len - 3; buf[--i] = '.');
 	XSetForeground(drw->dpy, drw->gc, drw->scheme->fg->rgb.pixel);
+	STATBEGIN(sp, NextRequest(drw->dpy), drw->drawable, -1);
 	pango_layout_set_text(drw->font->layout, buf, len);
 	pango_xft_render_layout(drw->xftdrawable, &drw->scheme->fg->rgb, drw->font->layout, tx * PANGO_SCALE, ty * PANGO_SCALE);
+	STATEND(sp, drwstats[DrwRender], NextRequest(drw->dpy));
 }
 
 void
@@ -165,10 +240,14 @@ drw_map(Drw *drw, Window win, int x, int y, unsigned int w, unsigned int h) {
 
 void
 drw_font_getexts(Fnt *font, const char *text, unsigned int len, Extnts *tex) {
+	STATSPAN(sp);
+
 	if(!font || !text)
 		return;
+	STATBEGIN(sp, 0, 0, -1);
 	pango_layout_set_text(font->layout, text, len);
 	pango_layout_get_pixel_size(font->layout, &tex->w, &tex->h);
+	STATEND(sp, drwstats[DrwExtents], 0);
 }
 
 unsigned int
@@ -47,6 +47,9 @@ void drw_free(Drw *drw);
 /* Fnt abstraction */
 Fnt *drw_font_create(Display *dpy, int screen, const char *fontname);
 void drw_font_free(Display *dpy, Fnt *font);
+int drw_font_guessh(Display *dpy, int screen, const char *fontname);
+int drw_font_preload(void);
+void drw_font_preload_wait(void);
 void drw_font_getexts(Fnt *font, const char *text, unsigned int len, Extnts *extnts);
 unsigned int drw_font_getexts_width(Fnt *font, const char *text, unsigned int len);
 
@@ -11,24 +11,33 @@
  * in O(1) time.
  *
  * Each child of the root window is called a client, except windows which have
- * set the override_redirect flag.  Clients are organized in a linked client
- * list on each monitor, the focus history is remembered through a stack list
- * on each monitor. Each client contains a bit array to indicate the tags of a
- * client.
+ * set the override_redirect flag.  Clients are organized in a doubly linked
+ * client list on each monitor, the focus history is remembered through a
+ * doubly linked stack list on each monitor. In both lists the prev pointer of
+ * the head points to the tail. Each client contains a bit array to indicate
+ * the tags of a client.
  *
  * Keys and tagging rules are organized as arrays and defined in config.h.
  *
  * To understand everything else, start reading main().
  */
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <locale.h>
 #include <stdarg.h>
 #include <signal.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <X11/cursorfont.h>
 #include <X11/keysym.h>
@@ -37,11 +46,18 @@
 #include <X11/Xlib.h>
 #include <X11/Xproto.h>
 #include <X11/Xutil.h>
+#include <X11/extensions/sync.h>
 #ifdef XINERAMA
 #include <X11/extensions/Xinerama.h>
 #endif /* XINERAMA */
+#ifdef XRANDR
+#include <X11/extensions/Xrandr.h>
+#endif /* XRANDR */
 
 #include "drw.h"
+#include "record.h"
+#include "state.h"
+#include "stats.h"
 #include "util.h"
 
 /* macros */
@@ -49,11 +65,16 @@
 #define CLEANMASK(mask)         (mask & ~(numlockmask|LockMask) & (ShiftMask|ControlMask|Mod1Mask|Mod2Mask|Mod3Mask|Mod4Mask|Mod5Mask))
 #define INTERSECT(x,y,w,h,m)    (MAX(0, MIN((x)+(w),(m)->wx+(m)->ww) - MAX((x),(m)->wx)) \
                                * MAX(0, MIN((y)+(h),(m)->wy+(m)->wh) - MAX((y),(m)->wy)))
+#define INSIDE(x,y,m)           ((x) >= (m)->mx && (x) < (m)->mx + (m)->mw \
+                               && (y) >= (m)->my && (y) < (m)->my + (m)->mh)
 #define ISVISIBLE(C)            ((C->tags & C->mon->tagset[C->mon->seltags]))
 #define LENGTH(X)               (sizeof X / sizeof X[0])
 #define MOUSEMASK               (BUTTONMASK|PointerMotionMask)
 #define WIDTH(X)                ((X)->w + 2 * (X)->bw)
 #define HEIGHT(X)               ((X)->h + 2 * (X)->bw)
+#define LAYOUTCACHE             4   /* memoized layout results per monitor */
+#define POOLSIZE                64  /* clients allocated at once */
+#define SYNCTIMEOUT             500 /* ms to wait for a sync request ack */
 #define TAGMASK                 ((1 << LENGTH(tags)) - 1)
 #define TEXTW(X)                (drw_font_getexts_width(drw->font, X, strlen(X)) + drw->font->h)
 
@@ -62,8 +83,12 @@ enum { CurNormal, CurResize, CurMove, CurLast }; /* cursor */
 enum { SchemeNorm, SchemeSel, SchemeUrg, SchemeLast }; /* color schemes */
 enum { NetSupported, NetWMName, NetWMState, NetWMFullscreen,
        NetWMDemandsAttention, NetActiveWindow, NetWMWindowType,
-       NetWMWindowTypeDialog, NetClientList, NetLast }; /* EWMH atoms */
+       NetWMWindowTypeDialog, NetClientList, NetClientListStacking,
+       NetWMSyncRequest, NetWMSyncRequestCounter, NetLast }; /* EWMH atoms */
 enum { WMProtocols, WMDelete, WMState, WMTakeFocus, WMLast }; /* default atoms */
+enum { OpArrange, OpRestack, OpDrawbar, OpManage, OpUnmanage,
+       OpLast }; /* operations measured with STATS or TRACE */
+enum { ArgNone, ArgInt, ArgUint, ArgFloat, ArgLayout, ArgShell }; /* IPC arguments */
 enum { ClkTagBar, ClkLtSymbol, ClkStatusText, ClkClientWin,
        ClkRootWin, ClkLast }; /* clicks */
 
@@ -82,22 +107,50 @@ typedef struct {
 	const Arg arg;
 } Button;
 
+typedef struct {
+	const char *name;
+	void (*func)(const Arg *arg);
+	int argtype;
+} Command;
+
 typedef struct Monitor Monitor;
 typedef struct Client Client;
-struct Client {
+typedef struct Pool Pool;
+typedef struct IpcClient IpcClient;
+
+/* rarely used client data, kept apart from the fields list walks touch */
+typedef struct {
 	char name[256];
 	float mina, maxa;
-	float cfact;
-	int x, y, w, h;
-	int oldx, oldy, oldw, oldh;
 	int basew, baseh, incw, inch, maxw, maxh, minw, minh;
-	int bw, oldbw;
-	unsigned int tags;
-	Bool isfixed, isfloating, attachaside, isurgent, neverfocus, oldstate, isfullscreen;
-	Client *next;
-	Client *snext;
+	XSyncCounter synccounter;  /* _NET_WM_SYNC_REQUEST_COUNTER */
+	XSyncAlarm syncalarm;      /* exists during resizemouse() */
+	XSyncValue syncvalue;      /* last value requested */
+} ClientInfo;
+
+struct Client {
+	Client *next, *prev;
+	Client *snext, *sprev;
 	Monitor *mon;
 	Window win;
+	unsigned int tags;
+	unsigned int isfixed : 1, isfloating : 1, attachaside : 1, isurgent : 1,
+	             neverfocus : 1, oldstate : 1, isfullscreen : 1,
+	             ishidden : 1; /* window is moved off screen by showhide() */
+	int x, y, w, h;
+	int bw;
+	float cfact;
+	int oldx, oldy, oldw, oldh;
+	int oldbw;
+	ClientInfo *info;
+};
+
+/* clients are allocated in pools, their infos in a separate array so that
+ * the hot parts of neighbouring clients share cache lines */
+struct Pool {
+	Client clients[POOLSIZE];
+	ClientInfo info[POOLSIZE];
+	Pool *next;
 };
 
 typedef struct {
@@ -107,11 +160,35 @@ typedef struct {
 	const Arg arg;
 } Key;
 
+typedef struct {
+	int x, y, w, h;
+} Rect;
+
 typedef struct {
 	const char *symbol;
-	void (*arrange)(Monitor *);
+	void (*arrange)(Monitor *, Client **, unsigned int, Rect *);
 } Layout;
 
+typedef struct {
+	Window win;
+	float cfact;
+	int bw;
+} LayoutKey;
+
+typedef struct {
+	unsigned int tagset;
+	const Layout *lt;
+	float mfact;
+	int nmaster;
+	int wx, wy, ww, wh;
+	unsigned int gen;     /* layoutgen the result was computed with */
+	unsigned int nvis;    /* visible clients, for the monocle symbol */
+	unsigned int n, size;
+	LayoutKey *keys;      /* tiled clients in layout order */
+	Rect *geom;
+	char ltsymbol[16];
+} LayoutCache;
+
 struct Monitor {
 	char ltsymbol[16];
 	float mfact;
@@ -125,12 +202,43 @@ struct Monitor {
 	unsigned int tagset[2];
 	Bool showbar;
 	Bool topbar;
+	Bool dirty;           /* geometry changed, see updatescreen() */
+	Bool present;         /* output still active, see updategeom() */
+	XID output;           /* RandR output identifying the monitor */
+	Bool tiledstale;      /* tiled needs to be rebuilt, see updatetiled() */
+	unsigned int ntiled, nvisible, tiledsize;
+	Client **tiled;       /* visible tiled clients in list order */
+	unsigned int nstacked, stackedsize;
+	Window *stacked;      /* bar and tiled clients as last restacked */
+	Window raised;        /* client last raised by restack() */
+	unsigned int evtags, evocc, evurg; /* as last reported by ipcnotify() */
+	char evltsymbol[16];
 	Client *clients;
 	Client *sel;
 	Client *stack;
 	Monitor *next;
 	Window barwin;
 	const Layout *lt[2];
+	LayoutCache cache[LAYOUTCACHE];
+	unsigned int nextcache;
+};
+
+typedef struct {
+	Window *wins;
+	unsigned int n, size;
+} WinList;
+
+typedef struct {
+	Window win;
+	unsigned int i;       /* index in the last restack */
+} StackPos;
+
+struct IpcClient {
+	int fd;               /* -1 once the connection failed */
+	Bool subscribed;
+	unsigned int len;
+	char buf[512];        /* partial request line */
+	IpcClient *next;
 };
 
 typedef struct {
@@ -149,22 +257,28 @@ static Bool applysizehints(Client *c, int *x, int *y, int *w, int *h, Bool inter
 static void arrange(Monitor *m);
 static void arrangemon(Monitor *m);
 static void attach(Client *c);
+static void attachafter(Client *c, Client *at);
 static void attachaside(Client *c);
 static void attachstack(Client *c);
-static void bstack(Monitor *m);
+static LayoutCache *cachelayout(Monitor *m, Client **c, unsigned int n, unsigned int nvis);
+static void bstack(Monitor *m, Client **c, unsigned int n, Rect *r);
 static void buttonpress(XEvent *e);
 static void checkotherwm(void);
 static void cleanup(void);
 static void cleanupmon(Monitor *mon);
 static void clearurgent(Client *c);
 static void clientmessage(XEvent *e);
+static void coalescemotion(XEvent *ev);
+static void commitlayout(Client **c, Rect *r, unsigned int n);
 static void configure(Client *c);
 static void configurenotify(XEvent *e);
 static void configurerequest(XEvent *e);
+static Client *createclient(void);
 static Monitor *createmon(void);
 static void destroynotify(XEvent *e);
 static void detach(Client *c);
 static void detachstack(Client *c);
+static void displaypath(char *buf, size_t size, const char *path);
 static Monitor *dirtomon(int dir);
 static void drawbar(Monitor *m);
 static void drawbars(void);
@@ -174,49 +288,76 @@ static void focus(Client *c);
 static void focusin(XEvent *e);
 static void focusmon(const Arg *arg);
 static void focusstack(const Arg *arg);
+static void freeclient(Client *c);
 static Bool getrootptr(int *x, int *y);
 static long getstate(Window w);
 static Bool gettextprop(Window w, Atom atom, char *text, unsigned int size);
 static void grabbuttons(Client *c, Bool focused);
 static void grabkeys(void);
+static void handleevents(void);
 static void incnmaster(const Arg *arg);
+static void ipcaccept(void);
+static void ipcevent(IpcClient *to, const char *fmt, ...);
+static void ipcinit(void);
+static void ipcnotify(IpcClient *to);
+static void ipcpoll(fd_set *rfds);
+static void ipcread(IpcClient *ic);
+static void ipcrequest(IpcClient *ic, char *line);
+static void ipcsend(IpcClient *ic, const char *fmt, ...);
+static void ipcwrite(IpcClient *ic, const char *buf, int len);
 static void keypress(XEvent *e);
 static void killclient(const Arg *arg);
+static void loadfont(void);
 static void manage(Window w, XWindowAttributes *wa);
 static void mappingnotify(XEvent *e);
 static void maprequest(XEvent *e);
-static void monocle(Monitor *m);
+static void monocle(Monitor *m, Client **c, unsigned int n, Rect *r);
 static void motionnotify(XEvent *e);
 static void movemouse(const Arg *arg);
+static void moveresize(Client *c, int x, int y, int w, int h);
 static Client *nexttiled(Client *c);
+static Monitor *pointtomon(int x, int y);
 static void pop(Client *);
 static Client *prevtiled(Client *c);
 static void propertynotify(XEvent *e);
 static void pushdown(const Arg *arg);
 static void pushup(const Arg *arg);
 static void quit(const Arg *arg);
+static void record(XEvent *ev);
+static void recordatom(Atom a);
+static void recordipc(const char *name, const char *arg);
+static void recordproperty(Record *r, Bool value);
+static Bool recordstart(const char *path);
+static void recordstop(void);
+static void recordwindow(Window w, XWindowAttributes *wa);
+static void recordwrite(Record *r, const void *data);
 static Monitor *recttomon(int x, int y, int w, int h);
 static void resize(Client *c, int x, int y, int w, int h, Bool interact);
 static void resizeclient(Client *c, int x, int y, int w, int h);
 static void resizemouse(const Arg *arg);
 static void restack(Monitor *m);
+static void restacktiled(Monitor *m, Window *wins, unsigned int n);
 static void run(void);
 static void scan(void);
 static Bool sendevent(Client *c, Atom proto);
-static void sendmon(Client *c, Monitor *m);
+static void selectclient(Client *c);
+static void sendmon(Client *c, Monitor *m, Bool follow);
 static void setclientstate(Client *c, long state);
 static void setfocus(Client *c);
 static void setfullscreen(Client *c, Bool fullscreen);
 static void setlayout(const Arg *arg);
 static void setcfact(const Arg *arg);
 static void setmfact(const Arg *arg);
+static void setrect(Client *c, Rect *r, int x, int y, int w, int h);
 static void setup(void);
-static void showhide(Client *c);
+static void showhide(Monitor *m);
 static void sigchld(int unused);
+static void stateinit(void);
+static Bool syncresize(Client *c, int x, int y, int w, int h, Time t);
 static void spawn(const Arg *arg);
 static void tag(const Arg *arg);
 static void tagmon(const Arg *arg);
-static void tile(Monitor *);
+static void tile(Monitor *m, Client **c, unsigned int n, Rect *r);
 static void togglebar(const Arg *arg);
 static void togglefloating(const Arg *arg);
 static void toggletag(const Arg *arg);
@@ -227,10 +368,16 @@ static void unmapnotify(XEvent *e);
 static Bool updategeom(void);
 static void updatebarpos(Monitor *m);
 static void updatebars(void);
+static void updatemonindex(void);
 static void updateclientlist(void);
+static void updatewinlist(Atom prop, WinList *l, Window *wins, unsigned int n);
 static void updatenumlockmask(void);
+static void updatescreen(void);
 static void updatesizehints(Client *c);
+static void updatestate(void);
 static void updatestatus(void);
+static void updatesynccounter(Client *c);
+static void updatetiled(Monitor *m);
 static void updatewindowtype(Client *c);
 static void updatetitle(Client *c);
 static void updatewmhints(Client *c);
@@ -241,6 +388,15 @@ static int xerror(Display *dpy, XErrorEvent *ee);
 static int xerrordummy(Display *dpy, XErrorEvent *ee);
 static int xerrorstart(Display *dpy, XErrorEvent *ee);
 static void zoom(const Arg *arg);
+#if defined(STATS) || defined(TRACE)
+static void sigusr1(int unused);
+static void writestats(void);
+#endif /* STATS || TRACE */
+#ifdef STATS
+static void bindname(char *buf, size_t size, unsigned int mod, const char *what);
+static void measure(Stat *dispatch, Stat *settle, const StatSpan *sp, Time t);
+static void measureinit(void);
+#endif /* STATS */
 
 /* variables */
 static const char broken[] = "broken";
@@ -248,6 +404,23 @@ static char stext[256];
 static int screen;
 static int sw, sh;           /* X display screen geometry width, height */
 static int bh, blw = 0;      /* bar geometry */
+static int fontfd = -1;      /* readable once the font can be created */
+static int syncevbase = -1;  /* SYNC extension, -1 if unavailable */
+#ifdef XRANDR
+static int rrevbase = -1;    /* RandR extension, -1 if unavailable */
+#endif /* XRANDR */
+static Bool screenstale = False; /* monitors need updatescreen() */
+static int ipcfd = -1;
+static IpcClient *ipcclients;
+static int evmon = -1;       /* focus as last reported by ipcnotify() */
+static Window evsel;
+static State *state;         /* mapped statefile, see state.h */
+static char ipcpath[256], statepath[256]; /* see displaypath() */
+static FILE *recfile;        /* capture being written, see record.h */
+static struct timespec rectime; /* time of the last record */
+static Atom *recatoms;       /* atoms already named in the capture */
+static unsigned int nrecatoms;
+static unsigned int layoutgen = 0; /* invalidates all memoized layouts */
 static int (*xerrorxlib)(Display *, XErrorEvent *);
 static unsigned int numlockmask = 0;
 static void (*handler[LASTEvent]) (XEvent *) = {
@@ -266,6 +439,32 @@ static void (*handler[LASTEvent]) (XEvent *) = {
 	[PropertyNotify] = propertynotify,
 	[UnmapNotify] = unmapnotify
 };
+#if defined(STATS) || defined(TRACE)
+static Stat evstats[LASTEvent] = {
+	[ButtonPress] = { "ButtonPress" },
+	[ClientMessage] = { "ClientMessage" },
+	[ConfigureRequest] = { "ConfigureRequest" },
+	[ConfigureNotify] = { "ConfigureNotify" },
+	[DestroyNotify] = { "DestroyNotify" },
+	[EnterNotify] = { "EnterNotify" },
+	[Expose] = { "Expose" },
+	[FocusIn] = { "FocusIn" },
+	[KeyPress] = { "KeyPress" },
+	[MappingNotify] = { "MappingNotify" },
+	[MapRequest] = { "MapRequest" },
+	[MotionNotify] = { "MotionNotify" },
+	[PropertyNotify] = { "PropertyNotify" },
+	[UnmapNotify] = { "UnmapNotify" }
+};
+static Stat opstats[OpLast] = {
+	[OpArrange] = { "arrange" },
+	[OpRestack] = { "restack" },
+	[OpDrawbar] = { "drawbar" },
+	[OpManage] = { "manage" },
+	[OpUnmanage] = { "unmanage" }
+};
+static volatile sig_atomic_t dumpstats = 0;
+#endif /* STATS || TRACE */
 static Atom wmatom[WMLast], netatom[NetLast];
 static Bool running = True;
 static Cur *cursor[CurLast];
@@ -274,7 +473,12 @@ static Display *dpy;
 static Drw *drw;
 static Fnt *fnt;
 static Monitor *mons, *selmon;
+static Monitor **monindex;   /* monitors sorted by x, see pointtomon() */
+static unsigned int nmonindex;
+static Pool *pools;
+static Client *freeclients; /* unused pool entries, linked by next */
 static Window root;
+static WinList clientlist, stackinglist; /* last published EWMH lists */
 
 /* configuration, allows nested code to access above variables */
 #include "config.h"
@@ -282,6 +486,17 @@ static Window root;
 /* compile-time check if all tags fit into an unsigned int bit array. */
 struct NumTags { char limitexceeded[LENGTH(tags) > 31 ? -1 : 1]; };
 
+#ifdef STATS
+/* input to settle latency of each binding, see measure() */
+static Stat keydispatch[LENGTH(keys)], keysettle[LENGTH(keys)];
+static Stat buttondispatch[LENGTH(buttons)], buttonsettle[LENGTH(buttons)];
+static char keynames[LENGTH(keys)][64], buttonnames[LENGTH(buttons)][64];
+static Window markwin;
+static Atom markatom;
+static Stat *marksettle;     /* binding whose marker is in flight */
+static Time marktime;        /* server time of its input event */
+#endif /* STATS */
+
 /* function implementations */
 void
 applyrules(Client *c) {
@@ -299,7 +514,7 @@ applyrules(Client *c) {
 
 	for(i = 0; i < LENGTH(rules); i++) {
 		r = &rules[i];
-		if((!r->title || strstr(c->name, r->title))
+		if((!r->title || strstr(c->info->name, r->title))
 		&& (!r->class || strstr(class, r->class))
 		&& (!r->instance || strstr(instance, r->instance)))
 		{
@@ -357,118 +572,224 @@ applysizehints(Client *c, int *x, int *y, int *w, int *h, Bool interact) {
 		*w = bh;
 	if(resizehints || c->isfloating || !c->mon->lt[c->mon->sellt]->arrange) {
 		/* see last two sentences in ICCCM 4.1.2.3 */
-		baseismin = c->basew == c->minw && c->baseh == c->minh;
+		baseismin = c->info->basew == c->info->minw && c->info->baseh == c->info->minh;
 		if(!baseismin) { /* temporarily remove base dimensions */
-			*w -= c->basew;
-			*h -= c->baseh;
+			*w -= c->info->basew;
+			*h -= c->info->baseh;
 		}
 		/* adjust for aspect limits */
-		if(c->mina > 0 && c->maxa > 0) {
-			if(c->maxa < (float)*w / *h)
-				*w = *h * c->maxa + 0.5;
-			else if(c->mina < (float)*h / *w)
-				*h = *w * c->mina + 0.5;
+		if(c->info->mina > 0 && c->info->maxa > 0) {
+			if(c->info->maxa < (float)*w / *h)
+				*w = *h * c->info->maxa + 0.5;
+			else if(c->info->mina < (float)*h / *w)
+				*h = *w * c->info->mina + 0.5;
 		}
 		if(baseismin) { /* increment calculation requires this */
-			*w -= c->basew;
-			*h -= c->baseh;
+			*w -= c->info->basew;
+			*h -= c->info->baseh;
 		}
 		/* adjust for increment value */
-		if(c->incw)
-			*w -= *w % c->incw;
-		if(c->inch)
-			*h -= *h % c->inch;
+		if(c->info->incw)
+			*w -= *w % c->info->incw;
+		if(c->info->inch)
+			*h -= *h % c->info->inch;
 		/* restore base dimensions */
-		*w = MAX(*w + c->basew, c->minw);
-		*h = MAX(*h + c->baseh, c->minh);
-		if(c->maxw)
-			*w = MIN(*w, c->maxw);
-		if(c->maxh)
-			*h = MIN(*h, c->maxh);
+		*w = MAX(*w + c->info->basew, c->info->minw);
+		*h = MAX(*h + c->info->baseh, c->info->minh);
+		if(c->info->maxw)
+			*w = MIN(*w, c->info->maxw);
+		if(c->info->maxh)
+			*h = MIN(*h, c->info->maxh);
 	}
 	return *x != c->x || *y != c->y || *w != c->w || *h != c->h;
 }
 
 void
 arrange(Monitor *m) {
+	STATSPAN(sp);
+
+	STATBEGIN(sp, NextRequest(dpy), None, m ? m->num : -1);
 	if(m)
-		showhide(m->stack);
+		showhide(m);
 	else for(m = mons; m; m = m->next)
-		showhide(m->stack);
+		showhide(m);
 	if(m) {
 		arrangemon(m);
 		restack(m);
 	} else for(m = mons; m; m = m->next)
 		arrangemon(m);
+	STATEND(sp, opstats[OpArrange], NextRequest(dpy));
 }
 
 void
 arrangemon(Monitor *m) {
+	unsigned int i;
+	Client *c;
+	LayoutCache *lc;
+
 	strncpy(m->ltsymbol, m->lt[m->sellt]->symbol, sizeof m->ltsymbol);
-	if(m->lt[m->sellt]->arrange)
-		m->lt[m->sellt]->arrange(m);
+	if(!m->lt[m->sellt]->arrange)
+		return;
+	updatetiled(m);
+	lc = cachelayout(m, m->tiled, m->ntiled, m->nvisible);
+	strncpy(m->ltsymbol, lc->ltsymbol, sizeof m->ltsymbol);
+	if(lazymonocle && m->lt[m->sellt]->arrange == monocle) {
+		/* only the tiled client on top of the stack can be seen, the
+		 * others are configured by focus() once they get there */
+		for(c = m->stack; c && (c->isfloating || !ISVISIBLE(c)); c = c->snext);
+		for(i = 0; i < m->ntiled && m->tiled[i] != c; i++);
+		if(i < m->ntiled)
+			commitlayout(&m->tiled[i], &lc->geom[i], 1);
+	}
+	else
+		commitlayout(m->tiled, lc->geom, m->ntiled);
 }
 
 void
 attachaside(Client *c) {
-	Client *at = nexttiled(c->mon->clients);
+	Client *at;
 
+	updatetiled(c->mon);
+	at = c->mon->ntiled ? c->mon->tiled[0] : NULL;
 	if(c->mon->sel == NULL || c->mon->sel->isfloating || !at) {
 		attach(c);
 		return;
 	}
-	c->next = at->next;
-	at->next = c;
+	attachafter(c, at);
 }
 
 void
 attach(Client *c) {
-	c->next = c->mon->clients;
+	Client *head = c->mon->clients;
+
+	c->next = head;
+	c->prev = head ? head->prev : c;
+	if(head)
+		head->prev = c;
 	c->mon->clients = c;
+	c->mon->tiledstale = True;
+}
+
+void
+attachafter(Client *c, Client *at) {
+	c->prev = at;
+	c->next = at->next;
+	if(at->next)
+		at->next->prev = c;
+	else
+		c->mon->clients->prev = c;
+	at->next = c;
+	c->mon->tiledstale = True;
 }
 
 void
 attachstack(Client *c) {
-	c->snext = c->mon->stack;
+	Client *head = c->mon->stack;
+
+	c->snext = head;
+	c->sprev = head ? head->sprev : c;
+	if(head)
+		head->sprev = c;
 	c->mon->stack = c;
 }
 
-void
-bstack(Monitor *m) {
-	unsigned int i, n, w, mh, mx, tx;
-	float mfacts = 0, sfacts = 0;
-	Client *c;
+/* Returns the memoized layout of the tiled clients c, computing it only if
+ * the view, the layout parameters or the clients changed since. */
+LayoutCache *
+cachelayout(Monitor *m, Client **c, unsigned int n, unsigned int nvis) {
+	unsigned int i, tagset = m->tagset[m->seltags];
+	const Layout *lt = m->lt[m->sellt];
+	LayoutCache *lc, *victim = NULL;
 
-	for(n = 0, c = nexttiled(m->clients); c; c = nexttiled(c->next), n++) {
-		if(n < m->nmaster)
-			mfacts += c->cfact;
-		else
-			sfacts += c->cfact;
-	}
+	for(lc = m->cache; lc < m->cache + LAYOUTCACHE; lc++) {
+		if(lc->tagset != tagset || !lc->lt)
+			continue;
+		if(lc->lt == lt && lc->gen == layoutgen && lc->n == n && lc->nvis == nvis
+		&& lc->mfact == m->mfact && lc->nmaster == m->nmaster
+		&& lc->wx == m->wx && lc->wy == m->wy && lc->ww == m->ww && lc->wh == m->wh) {
+			for(i = 0; i < n; i++)
+				if(lc->keys[i].win != c[i]->win || lc->keys[i].cfact != c[i]->cfact
+				|| lc->keys[i].bw != c[i]->bw)
+					break;
+			if(i == n)
+				return lc;
+		}
+		victim = lc; /* stale result of this view */
+	}
+	if(!(lc = victim)) {
+		lc = &m->cache[m->nextcache];
+		m->nextcache = (m->nextcache + 1) % LAYOUTCACHE;
+	}
+	if(n > lc->size) {
+		lc->size = MAX(n, 2 * lc->size);
+		if(!(lc->keys = realloc(lc->keys, lc->size * sizeof(LayoutKey)))
+		|| !(lc->geom = realloc(lc->geom, lc->size * sizeof(Rect))))
+			die("fatal: could not realloc() %u bytes\n", lc->size * sizeof(LayoutKey));
+	}
+	lc->tagset = tagset;
+	lc->lt = lt;
+	lc->mfact = m->mfact;
+	lc->nmaster = m->nmaster;
+	lc->wx = m->wx;
+	lc->wy = m->wy;
+	lc->ww = m->ww;
+	lc->wh = m->wh;
+	lc->gen = layoutgen;
+	lc->nvis = nvis;
+	lc->n = n;
+	for(i = 0; i < n; i++) {
+		lc->keys[i].win = c[i]->win;
+		lc->keys[i].cfact = c[i]->cfact;
+		lc->keys[i].bw = c[i]->bw;
+	}
+	lt->arrange(m, c, n, lc->geom);
+	strncpy(lc->ltsymbol, m->ltsymbol, sizeof lc->ltsymbol);
+	return lc;
+}
+
+void
+bstack(Monitor *m, Client **c, unsigned int n, Rect *r) {
+	unsigned int i, w, mh, mx, tx;
+	float mfacts = 0, sfacts = 0;
 
 	if(n == 0)
 		return;
+	for(i = 0; i < n; i++) {
+		if(i < m->nmaster)
+			mfacts += c[i]->cfact;
+		else
+			sfacts += c[i]->cfact;
+	}
 
 	if(n > m->nmaster)
 		mh = m->nmaster ? m->wh * m->mfact : 0;
 	else
 		mh = m->wh;
-	for(i = mx = tx = 0, c = nexttiled(m->clients); c; c = nexttiled(c->next), i++)
+	for(i = mx = tx = 0; i < n; i++)
 		if(i < m->nmaster) {
-			w = (m->ww - mx) / (MIN(n, m->nmaster) - i);
-			w = (m->ww - mx) * (c->cfact / mfacts);
-			resize(c, m->wx + mx, m->wy, w - (2*c->bw), mh - (2*c->bw), False);
-			mx += WIDTH(c);
-			mfacts -= c->cfact;
+			w = (m->ww - mx) * (c[i]->cfact / mfacts);
+			setrect(c[i], &r[i], m->wx + mx, m->wy, w - (2*c[i]->bw), mh - (2*c[i]->bw));
+			mx += r[i].w + 2 * c[i]->bw;
+			mfacts -= c[i]->cfact;
 		}
 		else {
-			w = (m->ww - tx) * (c->cfact / sfacts);
-			resize(c, m->wx + tx, m->wy + mh, w - (2*c->bw), m->wh - mh - (2*c->bw), False);
-			tx += WIDTH(c);
-			sfacts -= c->cfact;
+			w = (m->ww - tx) * (c[i]->cfact / sfacts);
+			setrect(c[i], &r[i], m->wx + tx, m->wy + mh, w - (2*c[i]->bw), m->wh - mh - (2*c[i]->bw));
+			tx += r[i].w + 2 * c[i]->bw;
+			sfacts -= c[i]->cfact;
 		}
 }
 
+#ifdef STATS
+void
+bindname(char *buf, size_t size, unsigned int mod, const char *what) {
+	snprintf(buf, size, "%s%s%s%s%s%s%s", mod & ControlMask ? "Control-" : "",
+	         mod & Mod1Mask ? "Mod1-" : "", mod & Mod3Mask ? "Mod3-" : "",
+	         mod & Mod4Mask ? "Mod4-" : "", mod & Mod5Mask ? "Mod5-" : "",
+	         mod & ShiftMask ? "Shift-" : "", what ? what : "?");
+}
+#endif /* STATS */
+
 void
 buttonpress(XEvent *e) {
 	unsigned int i, x, click;
@@ -476,15 +797,19 @@ buttonpress(XEvent *e) {
 	Client *c;
 	Monitor *m;
 	XButtonPressedEvent *ev = &e->xbutton;
+#ifdef STATS
+	StatSpan sp;
+#endif /* STATS */
 
 	click = ClkRootWin;
 	/* focus monitor if necessary */
-	if((m = wintomon(ev->window)) && m != selmon) {
+	m = ev->window == root ? pointtomon(ev->x_root, ev->y_root) : wintomon(ev->window);
+	if(m && m != selmon) {
 		unfocus(selmon->sel, True);
 		selmon = m;
 		focus(NULL);
 	}
-	if(ev->window == selmon->barwin) {
+	if(ev->window == selmon->barwin && fnt) {
 		i = x = 0;
 		do
 			x += TEXTW(tags[i]);
@@ -505,7 +830,15 @@ buttonpress(XEvent *e) {
 	for(i = 0; i < LENGTH(buttons); i++)
 		if(click == buttons[i].click && buttons[i].func && buttons[i].button == ev->button
 		&& CLEANMASK(buttons[i].mask) == CLEANMASK(ev->state))
+		{
+#ifdef STATS
+			stats_begin(&sp, NextRequest(dpy), ev->window, selmon->num);
+#endif /* STATS */
 			buttons[i].func(click == ClkTagBar && buttons[i].arg.i == 0 ? &arg : &buttons[i].arg);
+#ifdef STATS
+			measure(&buttondispatch[i], &buttonsettle[i], &sp, ev->time);
+#endif /* STATS */
+		}
 }
 
 void
@@ -523,6 +856,8 @@ cleanup(void) {
 	Arg a = {.ui = ~0};
 	Layout foo = { "", NULL };
 	Monitor *m;
+	Pool *p;
+	IpcClient *ic;
 
 	view(&a);
 	selmon->lt[selmon->sellt] = &foo;
@@ -532,9 +867,15 @@ cleanup(void) {
 	XUngrabKey(dpy, AnyKey, AnyModifier, root);
 	while(mons)
 		cleanupmon(mons);
+	free(monindex);
+	while((p = pools)) {
+		pools = p->next;
+		free(p);
+	}
 	drw_cur_free(drw, cursor[CurNormal]);
 	drw_cur_free(drw, cursor[CurResize]);
 	drw_cur_free(drw, cursor[CurMove]);
+	drw_font_preload_wait();
 	drw_font_free(dpy, fnt);
 	drw_clr_free(scheme[SchemeNorm].border);
 	drw_clr_free(scheme[SchemeNorm].bg);
@@ -542,9 +883,30 @@ cleanup(void) {
 	drw_clr_free(scheme[SchemeSel].border);
 	drw_clr_free(scheme[SchemeSel].bg);
 	drw_clr_free(scheme[SchemeSel].fg);
+	drw_clr_free(scheme[SchemeUrg].border);
 	drw_clr_free(scheme[SchemeUrg].bg);
 	drw_clr_free(scheme[SchemeUrg].fg);
 	drw_free(drw);
+	free(clientlist.wins);
+	free(stackinglist.wins);
+	while((ic = ipcclients)) {
+		ipcclients = ic->next;
+		if(ic->fd >= 0)
+			close(ic->fd);
+		free(ic);
+	}
+	if(ipcfd >= 0) {
+		close(ipcfd);
+		unlink(ipcpath);
+	}
+	recordstop();
+	if(state) {
+		munmap(state, sizeof(State));
+		unlink(statepath);
+	}
+#ifdef STATS
+	XDestroyWindow(dpy, markwin);
+#endif /* STATS */
 	XSync(dpy, False);
 	XSetInputFocus(dpy, PointerRoot, RevertToPointerRoot, CurrentTime);
 	XDeleteProperty(dpy, root, netatom[NetActiveWindow]);
@@ -552,6 +914,7 @@ cleanup(void) {
 
 void
 cleanupmon(Monitor *mon) {
+	unsigned int i;
 	Monitor *m;
 
 	if(mon == mons)
@@ -562,6 +925,12 @@ cleanupmon(Monitor *mon) {
 	}
 	XUnmapWindow(dpy, mon->barwin);
 	XDestroyWindow(dpy, mon->barwin);
+	for(i = 0; i < LAYOUTCACHE; i++) {
+		free(mon->cache[i].keys);
+		free(mon->cache[i].geom);
+	}
+	free(mon->tiled);
+	free(mon->stacked);
 	free(mon);
 }
 
@@ -597,11 +966,48 @@ clientmessage(XEvent *e) {
 		if(!ISVISIBLE(c)) {
 			c->mon->seltags ^= 1;
 			c->mon->tagset[c->mon->seltags] = c->tags;
+			c->mon->tiledstale = True;
 		}
 		pop(c);
 	}
 }
 
+static Bool
+ismotion(Display *dpy, XEvent *ev, XPointer released) {
+	if(ev->type == ButtonRelease)
+		*(Bool *)released = True;
+	return ev->type == MotionNotify && !*(Bool *)released;
+}
+
+/* Replaces the MotionNotify ev by the last one queued before the next
+ * ButtonRelease, dropping the ones in between. */
+void
+coalescemotion(XEvent *ev) {
+	Bool released = False, dropped = False;
+
+	while(XCheckIfEvent(dpy, ev, ismotion, (XPointer)&released))
+		released = False, dropped = True;
+	if(dropped && recfile)
+		record(ev);
+}
+
+/* Applies the geometry computed by a layout, configuring only the clients
+ * whose geometry actually changes and syncing once for the whole batch. */
+void
+commitlayout(Client **c, Rect *r, unsigned int n) {
+	unsigned int i;
+	Bool dirty = False;
+
+	for(i = 0; i < n; i++)
+		if(r[i].x != c[i]->x || r[i].y != c[i]->y
+		|| r[i].w != c[i]->w || r[i].h != c[i]->h) {
+			moveresize(c[i], r[i].x, r[i].y, r[i].w, r[i].h);
+			dirty = True;
+		}
+	if(dirty)
+		XSync(dpy, False);
+}
+
 void
 configure(Client *c) {
 	XConfigureEvent ce;
@@ -622,23 +1028,13 @@ configure(Client *c) {
 
 void
 configurenotify(XEvent *e) {
-	Monitor *m;
 	XConfigureEvent *ev = &e->xconfigure;
-	Bool dirty;
 
-	// TODO: updategeom handling sucks, needs to be simplified
+	/* applied by updatescreen() once the event queue is drained */
 	if(ev->window == root) {
-		dirty = (sw != ev->width || sh != ev->height);
 		sw = ev->width;
 		sh = ev->height;
-		if(updategeom() || dirty) {
-			drw_resize(drw, sw, bh);
-			updatebars();
-			for(m = mons; m; m = m->next)
-				XMoveResizeWindow(dpy, m->barwin, m->wx, m->by, m->ww, bh);
-			focus(NULL);
-			arrange(NULL);
-		}
+		screenstale = True;
 	}
 }
 
@@ -695,6 +1091,33 @@ configurerequest(XEvent *e) {
 	XSync(dpy, False);
 }
 
+Client *
+createclient(void) {
+	unsigned int i;
+	Client *c;
+	ClientInfo *info;
+	Pool *p;
+
+	if(!freeclients) {
+		if(!(p = (Pool *)calloc(1, sizeof(Pool))))
+			die("fatal: could not malloc() %u bytes\n", sizeof(Pool));
+		p->next = pools;
+		pools = p;
+		for(i = POOLSIZE; i--; ) {
+			p->clients[i].info = &p->info[i];
+			p->clients[i].next = freeclients;
+			freeclients = &p->clients[i];
+		}
+	}
+	c = freeclients;
+	freeclients = c->next;
+	info = c->info;
+	memset(c, 0, sizeof(Client));
+	memset(info, 0, sizeof(ClientInfo));
+	c->info = info;
+	return c;
+}
+
 Monitor *
 createmon(void) {
 	Monitor *m;
@@ -709,6 +1132,7 @@ createmon(void) {
 	m->lt[0] = &layouts[0];
 	m->lt[1] = &layouts[1 % LENGTH(layouts)];
 	strncpy(m->ltsymbol, layouts[0].symbol, sizeof m->ltsymbol);
+	m->tiledstale = True;
 	return m;
 }
 
@@ -723,18 +1147,34 @@ destroynotify(XEvent *e) {
 
 void
 detach(Client *c) {
-	Client **tc;
+	Monitor *m = c->mon;
 
-	for(tc = &c->mon->clients; *tc && *tc != c; tc = &(*tc)->next);
-	*tc = c->next;
+	if(c == m->clients)
+		m->clients = c->next;
+	else
+		c->prev->next = c->next;
+	if(c->next)
+		c->next->prev = c->prev;
+	else if(m->clients)
+		m->clients->prev = c->prev;
+	c->next = c->prev = NULL;
+	m->tiledstale = True;
 }
 
 void
 detachstack(Client *c) {
-	Client **tc, *t;
+	Monitor *m = c->mon;
+	Client *t;
 
-	for(tc = &c->mon->stack; *tc && *tc != c; tc = &(*tc)->snext);
-	*tc = c->snext;
+	if(c == m->stack)
+		m->stack = c->snext;
+	else
+		c->sprev->snext = c->snext;
+	if(c->snext)
+		c->snext->sprev = c->sprev;
+	else if(m->stack)
+		m->stack->sprev = c->sprev;
+	c->snext = c->sprev = NULL;
 
 	if(c == c->mon->sel) {
 		for(t = c->mon->stack; t && !ISVISIBLE(t); t = t->snext);
@@ -757,12 +1197,35 @@ dirtomon(int dir) {
 	return m;
 }
 
+/* Expands the first %s in a path from config.h to the display number, so
+ * that instances on different displays do not share sockets and files. The
+ * path is not a format, any other % is taken literally. */
+void
+displaypath(char *buf, size_t size, const char *path) {
+	char num[16] = "0";
+	const char *d = strrchr(DisplayString(dpy), ':'), *s;
+	size_t n;
+
+	if(d && (n = strspn(++d, "0123456789")) > 0 && n < sizeof num) {
+		memcpy(num, d, n);
+		num[n] = '\0';
+	}
+	if((s = strstr(path, "%s")))
+		snprintf(buf, size, "%.*s%s%s", (int)(s - path), path, num, s + 2);
+	else
+		snprintf(buf, size, "%s", path);
+}
+
 void
 drawbar(Monitor *m) {
 	int x, xx, w;
 	unsigned int i, occ = 0, urg = 0;
 	Client *c;
+	STATSPAN(sp);
 
+	if(!fnt) /* bar is drawn once the font is loaded */
+		return;
+	STATBEGIN(sp, NextRequest(dpy), m->barwin, m->num);
 	for(c = m->clients; c; c = c->next) {
 		occ |= c->tags;
 		if(c->isurgent)
@@ -794,6 +1257,7 @@ drawbar(Monitor *m) {
 		drw_text(drw, x, 0, w, bh, NULL);
 	}
 	drw_map(drw, m->barwin, 0, 0, m->ww, bh);
+	STATEND(sp, opstats[OpDrawbar], NextRequest(dpy));
 }
 
 void
@@ -813,7 +1277,10 @@ enternotify(XEvent *e) {
 	if((ev->mode != NotifyNormal || ev->detail == NotifyInferior) && ev->window != root)
 		return;
 	c = wintoclient(ev->window);
-	m = c ? c->mon : wintomon(ev->window);
+	if(c)
+		m = c->mon;
+	else
+		m = ev->window == root ? pointtomon(ev->x_root, ev->y_root) : wintomon(ev->window);
 	if(m != selmon) {
 		unfocus(selmon->sel, True);
 		selmon = m;
@@ -834,6 +1301,12 @@ expose(XEvent *e) {
 
 void
 focus(Client *c) {
+	selectclient(c);
+	drawbars();
+}
+
+void
+selectclient(Client *c) {
 	if(!c || !ISVISIBLE(c))
 		for(c = selmon->stack; c && !ISVISIBLE(c); c = c->snext);
 	/* was if(selmon->sel) */
@@ -844,8 +1317,10 @@ focus(Client *c) {
 			selmon = c->mon;
 		if(c->isurgent)
 			clearurgent(c);
-		detachstack(c);
-		attachstack(c);
+		if(c != c->mon->stack) {
+			detachstack(c);
+			attachstack(c);
+		}
 		grabbuttons(c, True);
 		XSetWindowBorder(dpy, c->win, scheme[SchemeSel].border->rgb.pixel);
 		setfocus(c);
@@ -855,7 +1330,9 @@ focus(Client *c) {
 		XDeleteProperty(dpy, root, netatom[NetActiveWindow]);
 	}
 	selmon->sel = c;
-	drawbars();
+	if(c && lazymonocle && !c->isfloating && c->mon->lt[c->mon->sellt]->arrange == monocle)
+		arrangemon(c->mon);
+	updateclientlist();
 }
 
 void
@@ -882,7 +1359,7 @@ focusmon(const Arg *arg) {
 
 void
 focusstack(const Arg *arg) {
-	Client *c = NULL, *i;
+	Client *c = NULL;
 
 	if(!selmon->sel)
 		return;
@@ -891,21 +1368,20 @@ focusstack(const Arg *arg) {
 		if(!c)
 			for(c = selmon->clients; c && !ISVISIBLE(c); c = c->next);
 	}
-	else {
-		for(i = selmon->clients; i != selmon->sel; i = i->next)
-			if(ISVISIBLE(i))
-				c = i;
-		if(!c)
-			for(; i; i = i->next)
-				if(ISVISIBLE(i))
-					c = i;
-	}
+	else /* prev wraps around from the head to the tail */
+		for(c = selmon->sel->prev; c != selmon->sel && !ISVISIBLE(c); c = c->prev);
 	if(c) {
 		focus(c);
 		restack(selmon);
 	}
 }
 
+void
+freeclient(Client *c) {
+	c->next = freeclients;
+	freeclients = c;
+}
+
 Atom
 getatomprop(Client *c, Atom prop) {
 	int di;
@@ -1011,12 +1487,326 @@ grabkeys(void) {
 	}
 }
 
+/* Handles the queued events, then what is left to do once per batch. */
+void
+handleevents(void) {
+	XEvent ev;
+	STATSPAN(sp);
+
+	while(running && XPending(dpy)) {
+		XNextEvent(dpy, &ev);
+		if(recfile)
+			record(&ev);
+		if(ev.type < LASTEvent && handler[ev.type]) {
+			STATBEGIN(sp, NextRequest(dpy), ev.xany.window, selmon->num);
+			handler[ev.type](&ev); /* call handler */
+			STATEND(sp, evstats[ev.type], NextRequest(dpy));
+		}
+#ifdef XRANDR
+		else if(rrevbase >= 0 && (ev.type == rrevbase + RRScreenChangeNotify
+		     || ev.type == rrevbase + RRNotify))
+		{
+			XRRUpdateConfiguration(&ev);
+			screenstale = True;
+		}
+#endif /* XRANDR */
+	}
+	if(screenstale)
+		updatescreen();
+	ipcnotify(NULL);
+	updatestate();
+}
+
 void
 incnmaster(const Arg *arg) {
 	selmon->nmaster = MAX(selmon->nmaster + arg->i, 0);
 	arrange(selmon);
 }
 
+void
+ipcaccept(void) {
+	int fd;
+	IpcClient *ic;
+
+	if((fd = accept(ipcfd, NULL, NULL)) < 0)
+		return;
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	if(!(ic = (IpcClient *)calloc(1, sizeof(IpcClient))))
+		die("fatal: could not malloc() %u bytes\n", sizeof(IpcClient));
+	ic->fd = fd;
+	ic->next = ipcclients;
+	ipcclients = ic;
+}
+
+/* Sends a line to to, or to all subscribers if to is NULL. */
+void
+ipcevent(IpcClient *to, const char *fmt, ...) {
+	char buf[512];
+	int len;
+	IpcClient *ic;
+	va_list ap;
+
+	va_start(ap, fmt);
+	len = vsnprintf(buf, sizeof buf, fmt, ap);
+	va_end(ap);
+	len = MIN(len, (int)sizeof buf - 1);
+	if(to)
+		ipcwrite(to, buf, len);
+	else for(ic = ipcclients; ic; ic = ic->next)
+		if(ic->subscribed)
+			ipcwrite(ic, buf, len);
+}
+
+void
+ipcinit(void) {
+	struct sockaddr_un addr;
+	mode_t mask;
+
+	displaypath(ipcpath, sizeof ipcpath, ipcsocket);
+	if(strlen(ipcpath) >= sizeof addr.sun_path) {
+		fprintf(stderr, "dwm: ipc socket path too long: %s\n", ipcpath);
+		return;
+	}
+	memset(&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, ipcpath);
+	if((ipcfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+		perror("dwm: ipc socket failed");
+		return;
+	}
+	fcntl(ipcfd, F_SETFD, FD_CLOEXEC);
+	unlink(ipcpath);
+	/* commands include spawn, so only the user may connect */
+	mask = umask(077);
+	if(bind(ipcfd, (struct sockaddr *)&addr, sizeof addr) < 0 || listen(ipcfd, 8) < 0) {
+		fprintf(stderr, "dwm: ipc %s", ipcpath);
+		perror(" failed");
+		close(ipcfd);
+		ipcfd = -1;
+	}
+	umask(mask);
+}
+
+/* Reports the monitor state that changed since the last call to all
+ * subscribers, or all of it to the new subscriber to. The reported state is
+ * not kept while nobody subscribes, so a snapshot for the only subscriber
+ * brings it up to date. */
+void
+ipcnotify(IpcClient *to) {
+	unsigned int occ, urg;
+	Bool update;
+	Client *c;
+	IpcClient *ic;
+	Monitor *m;
+	Window sel;
+
+	for(ic = ipcclients; ic && !ic->subscribed; ic = ic->next);
+	if(!ic)
+		return;
+	for(ic = ipcclients; ic && (ic == to || !ic->subscribed); ic = ic->next);
+	update = !to || !ic;
+	for(m = mons; m; m = m->next) {
+		for(occ = urg = 0, c = m->clients; c; c = c->next) {
+			occ |= c->tags;
+			if(c->isurgent)
+				urg |= c->tags;
+		}
+		if(to || m->evtags != m->tagset[m->seltags] || m->evocc != occ || m->evurg != urg)
+			ipcevent(to, "tags %d %u %u %u\n", m->num, m->tagset[m->seltags], occ, urg);
+		if(to || strcmp(m->evltsymbol, m->ltsymbol))
+			ipcevent(to, "layout %d %s\n", m->num, m->ltsymbol);
+		if(update) {
+			m->evtags = m->tagset[m->seltags];
+			m->evocc = occ;
+			m->evurg = urg;
+			memcpy(m->evltsymbol, m->ltsymbol, sizeof m->evltsymbol);
+		}
+	}
+	sel = selmon->sel ? selmon->sel->win : None;
+	if(to || evmon != selmon->num || evsel != sel) {
+		ipcevent(to, "focus %d 0x%lx\n", selmon->num, sel);
+		if(update) {
+			evmon = selmon->num;
+			evsel = sel;
+		}
+	}
+}
+
+void
+ipcpoll(fd_set *rfds) {
+	IpcClient *ic, **tc;
+
+	for(ic = ipcclients; ic; ic = ic->next)
+		if(ic->fd >= 0 && FD_ISSET(ic->fd, rfds))
+			ipcread(ic);
+	for(tc = &ipcclients; (ic = *tc); ) {
+		if(ic->fd >= 0) {
+			tc = &ic->next;
+			continue;
+		}
+		*tc = ic->next;
+		free(ic);
+	}
+	if(FD_ISSET(ipcfd, rfds))
+		ipcaccept();
+}
+
+void
+ipcread(IpcClient *ic) {
+	char *line, *nl;
+	int n;
+
+	if((n = read(ic->fd, ic->buf + ic->len, sizeof ic->buf - ic->len)) <= 0) {
+		if(n == 0 || errno != EAGAIN) {
+			close(ic->fd);
+			ic->fd = -1;
+		}
+		return;
+	}
+	ic->len += n;
+	for(line = ic->buf; ic->fd >= 0 && (nl = memchr(line, '\n', ic->buf + ic->len - line)); line = nl + 1) {
+		*nl = '\0';
+		ipcrequest(ic, line);
+	}
+	if(ic->fd < 0)
+		return;
+	ic->len -= line - ic->buf;
+	if(ic->len == sizeof ic->buf) {
+		ipcsend(ic, "err line too long\n");
+		close(ic->fd);
+		ic->fd = -1;
+	}
+	else
+		memmove(ic->buf, line, ic->len);
+}
+
+void
+ipcrequest(IpcClient *ic, char *line) {
+	unsigned int i, l;
+	char *a, *end, name[sizeof ((ClientInfo *)0)->name];
+	const char *cmd[] = { "/bin/sh", "-c", NULL, NULL };
+	Arg arg = {0};
+	Client *c;
+	Monitor *m;
+
+	for(a = line; *a && *a != ' '; a++);
+	if(*a)
+		*a++ = '\0';
+	while(*a == ' ')
+		a++;
+	if(!strcmp(line, "monitors")) {
+		for(m = mons; m; m = m->next)
+			ipcsend(ic, "monitor %d %d %d %d %d %u %.2f %d %d %s\n", m->num,
+			        m->mx, m->my, m->mw, m->mh, m->tagset[m->seltags],
+			        m->mfact, m->nmaster, m == selmon, m->ltsymbol);
+	}
+	else if(!strcmp(line, "clients")) {
+		for(m = mons; m; m = m->next)
+			for(c = m->clients; c; c = c->next) {
+				/* titles must not break the line framing */
+				for(l = 0; (name[l] = c->info->name[l]); l++)
+					if((unsigned char)name[l] < ' ' || name[l] == 0x7f)
+						name[l] = ' ';
+				ipcsend(ic, "client 0x%lx %d %u %d %d %d %d %d %d %d %d %s\n",
+				        c->win, m->num, c->tags, c->x, c->y, c->w, c->h,
+				        c->isfloating, c->isfullscreen, c->isurgent,
+				        c == selmon->sel, name);
+			}
+	}
+#if defined(STATS) || defined(TRACE)
+	else if(!strcmp(line, "stats"))
+		writestats();
+#endif /* STATS || TRACE */
+	else if(!strcmp(line, "record")) {
+		recordstop();
+		if(*a && !recordstart(a)) {
+			ipcsend(ic, "err cannot open %s\n", a);
+			return;
+		}
+	}
+	else if(!strcmp(line, "subscribe")) {
+		ic->subscribed = True;
+		ipcsend(ic, "ok\n");
+		ipcnotify(ic);
+		return;
+	}
+	else {
+		for(i = 0; i < LENGTH(commands) && strcmp(commands[i].name, line); i++);
+		if(i == LENGTH(commands)) {
+			ipcsend(ic, "err unknown command %s\n", line);
+			return;
+		}
+		if(!*a && (commands[i].argtype == ArgInt || commands[i].argtype == ArgUint
+		|| commands[i].argtype == ArgFloat)) {
+			ipcsend(ic, "err missing argument\n");
+			return;
+		}
+		end = a;
+		switch(commands[i].argtype) {
+		case ArgInt:
+			arg.i = strtol(a, &end, 10);
+			break;
+		case ArgUint:
+			arg.ui = strtoul(a, &end, 0);
+			break;
+		case ArgFloat:
+			arg.f = strtof(a, &end);
+			break;
+		case ArgLayout: /* without index toggles like setlayout's {0} */
+			if(*a) {
+				l = strtoul(a, &end, 10);
+				if(l < LENGTH(layouts))
+					arg.v = &layouts[l];
+				else
+					end = a;
+			}
+			break;
+		case ArgShell:
+			if(!*a) {
+				ipcsend(ic, "err missing command\n");
+				return;
+			}
+			cmd[2] = a;
+			arg.v = cmd;
+			end = a + strlen(a);
+			break;
+		}
+		if(*end) {
+			ipcsend(ic, "err bad argument %s\n", a);
+			return;
+		}
+		if(recfile)
+			recordipc(line, a);
+		commands[i].func(&arg);
+	}
+	ipcsend(ic, "ok\n");
+}
+
+void
+ipcsend(IpcClient *ic, const char *fmt, ...) {
+	char buf[512];
+	int len;
+	va_list ap;
+
+	va_start(ap, fmt);
+	len = vsnprintf(buf, sizeof buf, fmt, ap);
+	va_end(ap);
+	ipcwrite(ic, buf, MIN(len, (int)sizeof buf - 1));
+}
+
+/* Connections that cannot take a line at once are dropped rather than
+ * blocking the event loop. */
+void
+ipcwrite(IpcClient *ic, const char *buf, int len) {
+	if(ic->fd < 0)
+		return;
+	if(send(ic->fd, buf, len, MSG_NOSIGNAL) != len) {
+		close(ic->fd);
+		ic->fd = -1;
+	}
+}
+
 #ifdef XINERAMA
 static Bool
 isuniquegeom(XineramaScreenInfo *unique, size_t n, XineramaScreenInfo *info) {
@@ -1033,6 +1823,9 @@ keypress(XEvent *e) {
 	unsigned int i;
 	KeySym keysym;
 	XKeyEvent *ev;
+#ifdef STATS
+	StatSpan sp;
+#endif /* STATS */
 
 	ev = &e->xkey;
 	keysym = XkbKeycodeToKeysym(dpy, (KeyCode)ev->keycode, 0, 0);
@@ -1040,7 +1833,15 @@ keypress(XEvent *e) {
 		if(keysym == keys[i].keysym
 		&& CLEANMASK(keys[i].mod) == CLEANMASK(ev->state)
 		&& keys[i].func)
+		{
+#ifdef STATS
+			stats_begin(&sp, NextRequest(dpy), ev->window, selmon->num);
+#endif /* STATS */
 			keys[i].func(&(keys[i].arg));
+#ifdef STATS
+			measure(&keydispatch[i], &keysettle[i], &sp, ev->time);
+#endif /* STATS */
+		}
 }
 
 void
@@ -1058,14 +1859,35 @@ killclient(const Arg *arg) {
 	}
 }
 
+void
+loadfont(void) {
+	Monitor *m;
+
+	drw_font_preload_wait();
+	fontfd = -1;
+	fnt = drw_font_create(dpy, screen, font);
+	drw_setfont(drw, fnt);
+	if(fnt->h + 6 != bh) {
+		bh = fnt->h + 6;
+		layoutgen++; /* bh is the minimum client size */
+		for(m = mons; m; m = m->next) {
+			updatebarpos(m);
+			XMoveResizeWindow(dpy, m->barwin, m->wx, m->by, m->ww, bh);
+		}
+		arrange(NULL);
+	}
+	drawbars();
+}
+
 void
 manage(Window w, XWindowAttributes *wa) {
 	Client *c, *t = NULL;
 	Window trans = None;
 	XWindowChanges wc;
+	STATSPAN(sp);
 
-	if(!(c = calloc(1, sizeof(Client))))
-		die("fatal: could not malloc() %u bytes\n", sizeof(Client));
+	STATBEGIN(sp, NextRequest(dpy), w, -1);
+	c = createclient();
 	c->win = w;
 	updatetitle(c);
 	if(XGetTransientForHint(dpy, w, &trans) && (t = wintoclient(trans))) {
@@ -1101,20 +1923,24 @@ manage(Window w, XWindowAttributes *wa) {
 	updatewindowtype(c);
 	updatesizehints(c);
 	updatewmhints(c);
+	updatesynccounter(c);
 	XSelectInput(dpy, w, EnterWindowMask|FocusChangeMask|PropertyChangeMask|StructureNotifyMask);
 	grabbuttons(c, False);
 	if(!c->isfloating)
 		c->isfloating = c->oldstate = trans != None || c->isfixed;
 	if(c->isfloating)
 		XRaiseWindow(dpy, c->win);
+	/* new windows are mapped on top */
+	c->mon->raised = None;
+	c->mon->nstacked = 0;
 	if(c->attachaside)
 		attachaside(c);
 	else
 		attach(c);
 	attachstack(c);
-	XChangeProperty(dpy, root, netatom[NetClientList], XA_WINDOW, 32, PropModeAppend,
-	                (unsigned char *) &(c->win), 1);
+	updateclientlist();
 	XMoveResizeWindow(dpy, c->win, c->x + 2 * sw, c->y, c->w, c->h); /* some windows require this */
+	c->ishidden = True;
 	setclientstate(c, NormalState);
 	if(c->mon == selmon)
 		unfocus(selmon->sel, False);
@@ -1122,6 +1948,7 @@ manage(Window w, XWindowAttributes *wa) {
 	arrange(c->mon);
 	XMapWindow(dpy, c->win);
 	focus(NULL);
+	STATEND(sp, opstats[OpManage], NextRequest(dpy));
 }
 
 void
@@ -1146,29 +1973,78 @@ maprequest(XEvent *e) {
 		manage(ev->window, &wa);
 }
 
+#ifdef STATS
+/* Records how long a binding took to run and, unless a measurement is
+ * already in flight, changes a property on markwin. The server reports the
+ * change only after everything the binding requested, so the time between
+ * the input event and the PropertyNotify is the input to settle latency. */
 void
-monocle(Monitor *m) {
-	unsigned int n = 0;
-	Client *c;
+measure(Stat *dispatch, Stat *settle, const StatSpan *sp, Time t) {
+	long one = 1;
+
+	stats_end(dispatch, sp, NextRequest(dpy));
+	if(marksettle)
+		return;
+	marksettle = settle;
+	marktime = t;
+	XChangeProperty(dpy, markwin, markatom, XA_CARDINAL, 32, PropModeReplace,
+	                (unsigned char *)&one, 1);
+}
+
+void
+measureinit(void) {
+	unsigned int i;
+	char what[32];
+	const char *clicks[] = { "tagbar", "ltsymbol", "status", "client", "root" };
+
+	markwin = XCreateSimpleWindow(dpy, root, -1, -1, 1, 1, 0, 0, 0);
+	markatom = XInternAtom(dpy, "_DWM_MARK", False);
+	XSelectInput(dpy, markwin, PropertyChangeMask);
+	for(i = 0; i < LENGTH(keys); i++) {
+		bindname(keynames[i], sizeof keynames[i], keys[i].mod, XKeysymToString(keys[i].keysym));
+		keydispatch[i].name = keysettle[i].name = keynames[i];
+	}
+	for(i = 0; i < LENGTH(buttons); i++) {
+		snprintf(what, sizeof what, "%s Button%u", buttons[i].click < LENGTH(clicks)
+		         ? clicks[buttons[i].click] : "?", buttons[i].button);
+		bindname(buttonnames[i], sizeof buttonnames[i], buttons[i].mask, what);
+		buttondispatch[i].name = buttonsettle[i].name = buttonnames[i];
+	}
+}
+#endif /* STATS */
+
+void
+monocle(Monitor *m, Client **c, unsigned int n, Rect *r) {
+	unsigned int i;
 
-	for(c = m->clients; c; c = c->next)
-		if(ISVISIBLE(c))
-			n++;
-	if(n > 0) /* override layout symbol */
-		snprintf(m->ltsymbol, sizeof m->ltsymbol, "%d", n);
-	for(c = nexttiled(m->clients); c; c = nexttiled(c->next))
-		resize(c, m->wx, m->wy, m->ww - 2 * c->bw, m->wh - 2 * c->bw, False);
+	if(m->nvisible > 0) /* override layout symbol */
+		snprintf(m->ltsymbol, sizeof m->ltsymbol, "%d", m->nvisible);
+	for(i = 0; i < n; i++)
+		setrect(c[i], &r[i], m->wx, m->wy, m->ww - 2 * c[i]->bw, m->wh - 2 * c[i]->bw);
 }
 
 void
 motionnotify(XEvent *e) {
 	static Monitor *mon = NULL;
+	Bool dropped = False;
 	Monitor *m;
+	XEvent next;
 	XMotionEvent *ev = &e->xmotion;
 
 	if(ev->window != root)
 		return;
-	if((m = recttomon(ev->x_root, ev->y_root, 1, 1)) != mon && mon) {
+	/* only the latest pointer position matters, but motion queued behind
+	 * other events must not overtake them */
+	while(XPending(dpy)) {
+		XPeekEvent(dpy, &next);
+		if(next.type != MotionNotify || next.xmotion.window != root)
+			break;
+		XNextEvent(dpy, e);
+		dropped = True;
+	}
+	if(dropped && recfile)
+		record(e);
+	if((m = pointtomon(ev->x_root, ev->y_root)) != mon && mon) {
 		unfocus(selmon->sel, True);
 		selmon = m;
 		focus(NULL);
@@ -1178,7 +2054,9 @@ motionnotify(XEvent *e) {
 
 void
 movemouse(const Arg *arg) {
-	int x, y, ocx, ocy, nx, ny;
+	int x, y, ocx, ocy, nx = 0, ny = 0;
+	Bool pending = False;
+	Time lasttime = 0, pendtime = 0;
 	Client *c;
 	Monitor *m;
 	XEvent ev;
@@ -1196,7 +2074,15 @@ movemouse(const Arg *arg) {
 	if(!getrootptr(&x, &y))
 		return;
 	do {
+		/* the pointer stopped, show where it stopped */
+		if(pending && !XPending(dpy)) {
+			pending = False;
+			lasttime = pendtime;
+			resize(c, nx, ny, c->w, c->h, True);
+		}
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
+		if(recfile)
+			record(&ev);
 		switch(ev.type) {
 		case ConfigureRequest:
 		case Expose:
@@ -1204,6 +2090,7 @@ movemouse(const Arg *arg) {
 			handler[ev.type](&ev);
 			break;
 		case MotionNotify:
+			coalescemotion(&ev);
 			nx = ocx + (ev.xmotion.x - x);
 			ny = ocy + (ev.xmotion.y - y);
 			if(nx >= selmon->wx && nx <= selmon->wx + selmon->ww
@@ -1220,25 +2107,66 @@ movemouse(const Arg *arg) {
 				&& (abs(nx - c->x) > snap || abs(ny - c->y) > snap))
 					togglefloating(NULL);
 			}
-			if(!selmon->lt[selmon->sellt]->arrange || c->isfloating)
+			if(!selmon->lt[selmon->sellt]->arrange || c->isfloating) {
+				/* commit at most refreshrate times per second */
+				if((pending = refreshrate && ev.xmotion.time - lasttime < 1000 / refreshrate)) {
+					pendtime = ev.xmotion.time;
+					break;
+				}
+				lasttime = ev.xmotion.time;
 				resize(c, nx, ny, c->w, c->h, True);
+			}
 			break;
 		}
 	} while(ev.type != ButtonRelease);
+	if(pending)
+		resize(c, nx, ny, c->w, c->h, True);
 	XUngrabPointer(dpy, CurrentTime);
-	if((m = recttomon(c->x, c->y, c->w, c->h)) != selmon) {
-		sendmon(c, m);
-		selmon = m;
-		focus(NULL);
-	}
+	if((m = recttomon(c->x, c->y, c->w, c->h)) != selmon)
+		sendmon(c, m, True);
 }
 
-Client *
-nexttiled(Client *c) {
-	for(; c && (c->isfloating || !ISVISIBLE(c)); c = c->next);
+void
+moveresize(Client *c, int x, int y, int w, int h) {
+	XWindowChanges wc;
+
+	c->oldx = c->x; c->x = wc.x = x;
+	c->oldy = c->y; c->y = wc.y = y;
+	c->oldw = c->w; c->w = wc.width = w;
+	c->oldh = c->h; c->h = wc.height = h;
+	wc.border_width = c->bw;
+	XConfigureWindow(dpy, c->win, CWX|CWY|CWWidth|CWHeight|CWBorderWidth, &wc);
+	configure(c);
+	c->ishidden = False;
+}
+
+Client *
+nexttiled(Client *c) {
+	for(; c && (c->isfloating || !ISVISIBLE(c)); c = c->next);
 	return c;
 }
 
+/* Returns the monitor containing the point, or selmon if there is none. */
+Monitor *
+pointtomon(int x, int y) {
+	int lo, hi, mid;
+
+	if(!selmon || INSIDE(x, y, selmon))
+		return selmon;
+	/* the last monitor starting left of x, then those before it */
+	for(lo = 0, hi = nmonindex; lo < hi; ) {
+		mid = (lo + hi) / 2;
+		if(monindex[mid]->mx <= x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	while(lo-- > 0)
+		if(INSIDE(x, y, monindex[lo]))
+			return monindex[lo];
+	return selmon;
+}
+
 void
 pop(Client *c) {
 	detach(c);
@@ -1249,12 +2177,12 @@ pop(Client *c) {
 
 Client *
 prevtiled(Client *c) {
-	Client *p, *r;
+	Client *p;
 
-	for(p = selmon->clients, r = NULL; p && p != c; p = p->next)
-		if(!p->isfloating && ISVISIBLE(p))
-			r = p;
-	return r;
+	for(p = c; p != c->mon->clients; )
+		if(!(p = p->prev)->isfloating && ISVISIBLE(p))
+			return p;
+	return NULL;
 }
 
 void
@@ -1263,6 +2191,14 @@ propertynotify(XEvent *e) {
 	Window trans;
 	XPropertyEvent *ev = &e->xproperty;
 
+#ifdef STATS
+	if(ev->window == markwin) { /* everything the binding sent is done */
+		if(marksettle)
+			stats_add(marksettle, ((ev->time - marktime) & 0xffffffff) * 1000ULL, 0, 0);
+		marksettle = NULL;
+		return;
+	}
+#endif /* STATS */
 	if((ev->window == root) && (ev->atom == XA_WM_NAME))
 		updatestatus();
 	else if(ev->state == PropertyDelete)
@@ -1272,8 +2208,10 @@ propertynotify(XEvent *e) {
 		default: break;
 		case XA_WM_TRANSIENT_FOR:
 			if(!c->isfloating && (XGetTransientForHint(dpy, c->win, &trans)) &&
-			   (c->isfloating = (wintoclient(trans)) != NULL))
+			   (c->isfloating = (wintoclient(trans)) != NULL)) {
+				c->mon->tiledstale = True;
 				arrange(c->mon);
+			}
 			break;
 		case XA_WM_NORMAL_HINTS:
 			updatesizehints(c);
@@ -1292,14 +2230,18 @@ propertynotify(XEvent *e) {
 
 void
 pushdown(const Arg *arg) {
+	unsigned int i;
 	Client *sel = selmon->sel, *c;
 
-	if(!sel || sel->isfloating || sel == nexttiled(selmon->clients))
+	if(!sel || sel->isfloating)
+		return;
+	updatetiled(selmon);
+	for(i = 0; i < selmon->ntiled && selmon->tiled[i] != sel; i++);
+	if(i == 0)
 		return;
-	if((c = nexttiled(sel->next))) {
+	if((c = i + 1 < selmon->ntiled ? selmon->tiled[i + 1] : NULL)) {
 		detach(sel);
-		sel->next = c->next;
-		c->next = sel;
+		attachafter(sel, c);
 	}
 	focus(sel);
 	arrange(selmon);
@@ -1311,11 +2253,10 @@ pushup(const Arg *arg) {
 
 	if(!sel || sel->isfloating)
 		return;
-	if((c = prevtiled(sel)) && c != nexttiled(selmon->clients)) {
+	updatetiled(selmon);
+	if((c = prevtiled(sel)) && c != selmon->tiled[0]) {
 		detach(sel);
-		sel->next = c;
-		for(c = selmon->clients; c->next != sel->next; c = c->next)
-			c->next = sel;
+		attachafter(sel, c->prev); /* c is not the head */
 	}
 	focus(sel);
 	arrange(selmon);
@@ -1326,6 +2267,243 @@ quit(const Arg *arg) {
 	running = False;
 }
 
+/* Appends ev to the capture, together with the atoms and property values the
+ * replay needs to reproduce it, see record.h. */
+void
+record(XEvent *ev) {
+	Record r = { 0 };
+	uint32_t data[5];
+	XWindowAttributes wa;
+	unsigned int i;
+
+	r.type = ev->type;
+	r.win = ev->xany.window;
+	switch(ev->type) {
+	case KeyPress:
+	case KeyRelease:
+		r.detail = ev->xkey.keycode;
+		r.arg = ev->xkey.state;
+		break;
+	case ButtonPress:
+	case ButtonRelease:
+		r.detail = ev->xbutton.button;
+		r.arg = ev->xbutton.state;
+		r.x = ev->xbutton.x_root;
+		r.y = ev->xbutton.y_root;
+		break;
+	case MotionNotify:
+		r.arg = ev->xmotion.state;
+		r.x = ev->xmotion.x_root;
+		r.y = ev->xmotion.y_root;
+		break;
+	case EnterNotify:
+		r.arg = ev->xcrossing.state;
+		r.x = ev->xcrossing.x_root;
+		r.y = ev->xcrossing.y_root;
+		break;
+	case MapRequest:
+		r.win = ev->xmaprequest.window;
+		if(!XGetWindowAttributes(dpy, r.win, &wa))
+			break;
+		if(!wintoclient(r.win))
+			recordwindow(r.win, &wa);
+		r.x = wa.x;
+		r.y = wa.y;
+		r.w = wa.width;
+		r.h = wa.height;
+		break;
+	case ConfigureRequest:
+		r.win = ev->xconfigurerequest.window;
+		r.detail = MIN(ev->xconfigurerequest.border_width, 255);
+		r.arg = ev->xconfigurerequest.value_mask;
+		r.x = ev->xconfigurerequest.x;
+		r.y = ev->xconfigurerequest.y;
+		r.w = ev->xconfigurerequest.width;
+		r.h = ev->xconfigurerequest.height;
+		break;
+	case UnmapNotify:
+		r.win = ev->xunmap.window;
+		r.detail = ev->xunmap.send_event;
+		r.arg = ev->xunmap.event;
+		break;
+	case DestroyNotify:
+		r.win = ev->xdestroywindow.window;
+		r.detail = ev->xdestroywindow.send_event;
+		r.arg = ev->xdestroywindow.event;
+		break;
+	case ClientMessage:
+		recordatom(ev->xclient.message_type);
+		if(ev->xclient.message_type == netatom[NetWMState]) {
+			recordatom(ev->xclient.data.l[1]);
+			recordatom(ev->xclient.data.l[2]);
+		}
+		r.detail = ev->xclient.format;
+		r.arg = ev->xclient.message_type;
+		if(ev->xclient.format == 32)
+			for(i = 0; i < LENGTH(data); i++)
+				data[i] = ev->xclient.data.l[i];
+		else
+			memcpy(data, ev->xclient.data.b, sizeof data);
+		r.len = sizeof data;
+		break;
+	case PropertyNotify:
+		/* the values of the properties dwm writes itself are left out */
+		r.detail = ev->xproperty.state;
+		r.arg = ev->xproperty.atom;
+		recordproperty(&r, ev->xproperty.atom != wmatom[WMState]
+		               && ev->xproperty.atom != netatom[NetWMState]
+		               && ev->xproperty.atom != netatom[NetSupported]
+		               && ev->xproperty.atom != netatom[NetActiveWindow]
+		               && ev->xproperty.atom != netatom[NetClientList]
+		               && ev->xproperty.atom != netatom[NetClientListStacking]);
+		return;
+	}
+	recordwrite(&r, data);
+}
+
+void
+recordatom(Atom a) {
+	Record r = { 0 };
+	char *name;
+	unsigned int i;
+
+	for(i = 0; i < nrecatoms && recatoms[i] != a; i++);
+	if(a == None || i < nrecatoms || !(name = XGetAtomName(dpy, a)))
+		return;
+	if(!(nrecatoms % 64) && !(recatoms = realloc(recatoms, (nrecatoms + 64) * sizeof(Atom))))
+		die("fatal: could not realloc() %u bytes\n", (nrecatoms + 64) * sizeof(Atom));
+	recatoms[nrecatoms++] = a;
+	r.type = RecAtom;
+	r.arg = a;
+	r.len = MIN(strlen(name), RECORDMAX);
+	recordwrite(&r, name);
+	XFree(name);
+}
+
+void
+recordipc(const char *name, const char *arg) {
+	Record r = { 0 };
+	char buf[sizeof ((IpcClient *)0)->buf];
+
+	r.type = RecIpc;
+	r.len = MIN(snprintf(buf, sizeof buf, *arg ? "%s %s" : "%s", name, arg), sizeof buf - 1);
+	recordwrite(&r, buf);
+}
+
+/* Writes r about property r->arg, with its value unless it was deleted or
+ * value is False. */
+void
+recordproperty(Record *r, Bool value) {
+	uint32_t data[RECORDMAX / 4];
+	unsigned char *p = NULL;
+	unsigned long i, n, extra;
+	int format;
+	Atom t;
+
+	recordatom(r->arg);
+	r->len = 0;
+	if(value && r->detail == PropertyNewValue
+	&& XGetWindowProperty(dpy, r->win, r->arg, 0L, RECORDMAX / 4 - 2, False, AnyPropertyType,
+	                      &t, &format, &n, &extra, &p) == Success && p)
+	{
+		recordatom(t);
+		data[0] = t;
+		data[1] = format;
+		if(format == 32)
+			for(i = 0; i < n; i++)
+				data[2 + i] = ((long *)p)[i];
+		else
+			memcpy(&data[2], p, n * format / 8);
+		r->len = 2 * sizeof(uint32_t) + n * (format == 32 ? sizeof(uint32_t) : format / 8);
+		XFree(p);
+	}
+	recordwrite(r, data);
+}
+
+/* Starts a capture at path, beginning with the clients already managed so
+ * that a replay starts from the same set of windows. */
+Bool
+recordstart(const char *path) {
+	RecordHeader h = { 0 };
+	XEvent ev = { 0 };
+	Client *c;
+	Monitor *m;
+	XWindowAttributes wa;
+
+	if(!(recfile = fopen(path, "w")))
+		return False;
+	h.root = root;
+	h.sw = sw;
+	h.sh = sh;
+	fwrite(RECORDMAGIC, 1, sizeof RECORDMAGIC - 1, recfile);
+	fwrite(&h, sizeof h, 1, recfile);
+	clock_gettime(CLOCK_MONOTONIC, &rectime);
+	ev.type = MapRequest;
+	for(m = mons; m && recfile; m = m->next)
+		for(c = m->clients ? m->clients->prev : NULL; c && recfile; c = c->prev) {
+			if(XGetWindowAttributes(dpy, c->win, &wa))
+				recordwindow(c->win, &wa);
+			ev.xmaprequest.window = c->win;
+			record(&ev);
+			if(c == m->clients)
+				break;
+		}
+	return recfile != NULL;
+}
+
+void
+recordstop(void) {
+	if(recfile)
+		fclose(recfile);
+	recfile = NULL;
+	free(recatoms);
+	recatoms = NULL;
+	nrecatoms = 0;
+}
+
+/* records all properties of w, before a MapRequest makes dwm read them */
+void
+recordwindow(Window w, XWindowAttributes *wa) {
+	Record r = { 0 };
+	Atom *a;
+	int i, n;
+
+	if(!(a = XListProperties(dpy, w, &n)))
+		return;
+	r.type = RecProperty;
+	r.detail = PropertyNewValue;
+	r.win = w;
+	r.x = wa->x;
+	r.y = wa->y;
+	r.w = wa->width;
+	r.h = wa->height;
+	for(i = 0; i < n && recfile; i++) {
+		r.arg = a[i];
+		recordproperty(&r, True);
+	}
+	XFree(a);
+}
+
+void
+recordwrite(Record *r, const void *data) {
+	struct timespec t;
+	unsigned long long us;
+
+	if(!recfile) /* stopped by an earlier write error */
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	us = (t.tv_sec - rectime.tv_sec) * 1000000ULL + t.tv_nsec / 1000 - rectime.tv_nsec / 1000;
+	rectime = t;
+	r->us = MIN(us, UINT32_MAX);
+	if(fwrite(r, sizeof *r, 1, recfile) != 1
+	|| (r->len && fwrite(data, r->len, 1, recfile) != 1))
+	{
+		fprintf(stderr, "dwm: recording");
+		perror(" failed");
+		recordstop();
+	}
+}
+
 Monitor *
 recttomon(int x, int y, int w, int h) {
 	Monitor *m, *r = selmon;
@@ -1347,25 +2525,34 @@ resize(Client *c, int x, int y, int w, int h, Bool interact) {
 
 void
 resizeclient(Client *c, int x, int y, int w, int h) {
-	XWindowChanges wc;
-
-	c->oldx = c->x; c->x = wc.x = x;
-	c->oldy = c->y; c->y = wc.y = y;
-	c->oldw = c->w; c->w = wc.width = w;
-	c->oldh = c->h; c->h = wc.height = h;
-	wc.border_width = c->bw;
-	XConfigureWindow(dpy, c->win, CWX|CWY|CWWidth|CWHeight|CWBorderWidth, &wc);
-	configure(c);
+	moveresize(c, x, y, w, h);
 	XSync(dpy, False);
 }
 
+static Bool
+isresizeevent(Display *dpy, XEvent *ev, XPointer arg) {
+	switch(ev->type) {
+	case ButtonPress:
+	case ButtonRelease:
+	case MotionNotify:
+	case ConfigureRequest:
+	case Expose:
+	case MapRequest:
+		return True;
+	}
+	return syncevbase >= 0 && ev->type == syncevbase + XSyncAlarmNotify;
+}
+
 void
 resizemouse(const Arg *arg) {
 	int ocx, ocy;
-	int nw, nh;
+	int nw = 0, nh = 0;
+	Bool pending = False, waiting = False;
+	Time lasttime = 0, pendtime = 0;
 	Client *c;
 	Monitor *m;
 	XEvent ev;
+	XSyncAlarmAttributes aa;
 
 	if(!(c = selmon->sel))
 		return;
@@ -1378,8 +2565,37 @@ resizemouse(const Arg *arg) {
 	                None, cursor[CurResize]->cursor, CurrentTime) != GrabSuccess)
 		return;
 	XWarpPointer(dpy, None, c->win, 0, 0, 0, 0, c->w + c->bw - 1, c->h + c->bw - 1);
+	/* pace configures to the repaints of clients supporting _NET_WM_SYNC_REQUEST */
+	if(c->info->synccounter && XSyncQueryCounter(dpy, c->info->synccounter, &c->info->syncvalue)) {
+		aa.trigger.counter = c->info->synccounter;
+		aa.trigger.value_type = XSyncAbsolute;
+		aa.trigger.wait_value = c->info->syncvalue;
+		aa.trigger.test_type = XSyncPositiveComparison;
+		aa.events = True;
+		c->info->syncalarm = XSyncCreateAlarm(dpy, XSyncCACounter|XSyncCAValueType
+		                                      |XSyncCAValue|XSyncCATestType|XSyncCAEvents, &aa);
+	}
 	do {
-		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
+		/* the pointer stopped, unless the client's frame will flush it */
+		if(pending && !waiting && !XPending(dpy)) {
+			pending = False;
+			lasttime = pendtime;
+			waiting = syncresize(c, c->x, c->y, nw, nh, lasttime);
+		}
+		XIfEvent(dpy, &ev, isresizeevent, NULL);
+		if(recfile)
+			record(&ev);
+		if(syncevbase >= 0 && ev.type == syncevbase + XSyncAlarmNotify) {
+			if(waiting && ((XSyncAlarmNotifyEvent *)&ev)->alarm == c->info->syncalarm
+			&& XSyncValueGreaterOrEqual(((XSyncAlarmNotifyEvent *)&ev)->counter_value, c->info->syncvalue)) {
+				waiting = False;
+				if(pending) {
+					pending = False;
+					waiting = syncresize(c, c->x, c->y, nw, nh, lasttime);
+				}
+			}
+			continue;
+		}
 		switch(ev.type) {
 		case ConfigureRequest:
 		case Expose:
@@ -1387,6 +2603,7 @@ resizemouse(const Arg *arg) {
 			handler[ev.type](&ev);
 			break;
 		case MotionNotify:
+			coalescemotion(&ev);
 			nw = MAX(ev.xmotion.x - ocx - 2 * c->bw + 1, 1);
 			nh = MAX(ev.xmotion.y - ocy - 2 * c->bw + 1, 1);
 			if(c->mon->wx + nw >= selmon->wx && c->mon->wx + nw <= selmon->wx + selmon->ww
@@ -1396,53 +2613,199 @@ resizemouse(const Arg *arg) {
 				&& (abs(nw - c->w) > snap || abs(nh - c->h) > snap))
 					togglefloating(NULL);
 			}
-			if(!selmon->lt[selmon->sellt]->arrange || c->isfloating)
-				resize(c, c->x, c->y, nw, nh, True);
+			if(!selmon->lt[selmon->sellt]->arrange || c->isfloating) {
+				/* hold back while the client has not drawn the last frame */
+				if((pending = (refreshrate && ev.xmotion.time - lasttime < 1000 / refreshrate)
+				|| (waiting && ev.xmotion.time - lasttime < SYNCTIMEOUT))) {
+					pendtime = ev.xmotion.time;
+					break;
+				}
+				lasttime = ev.xmotion.time;
+				waiting = syncresize(c, c->x, c->y, nw, nh, lasttime);
+			}
 			break;
 		}
 	} while(ev.type != ButtonRelease);
+	if(pending)
+		syncresize(c, c->x, c->y, nw, nh, ev.xbutton.time);
+	if(c->info->syncalarm) {
+		XSyncDestroyAlarm(dpy, c->info->syncalarm);
+		c->info->syncalarm = None;
+	}
 	XWarpPointer(dpy, None, c->win, 0, 0, 0, 0, c->w + c->bw - 1, c->h + c->bw - 1);
 	XUngrabPointer(dpy, CurrentTime);
 	while(XCheckMaskEvent(dpy, EnterWindowMask, &ev));
-	if((m = recttomon(c->x, c->y, c->w, c->h)) != selmon) {
-		sendmon(c, m);
-		selmon = m;
-		focus(NULL);
-	}
+	if((m = recttomon(c->x, c->y, c->w, c->h)) != selmon)
+		sendmon(c, m, True);
 }
 
 void
 restack(Monitor *m) {
+	static Window *wins = NULL;
+	static unsigned int size = 0;
+	unsigned int n;
 	Client *c;
 	XEvent ev;
-	XWindowChanges wc;
+	STATSPAN(sp);
 
 	drawbar(m);
 	if(!m->sel)
 		return;
-	if(m->sel->isfloating || !m->lt[m->sellt]->arrange)
-		XRaiseWindow(dpy, m->sel->win);
+	STATBEGIN(sp, NextRequest(dpy), m->sel->win, m->num);
 	if(m->lt[m->sellt]->arrange) {
-		wc.stack_mode = Below;
-		wc.sibling = m->barwin;
-		for(c = m->stack; c; c = c->snext)
+		/* tiled clients go below the bar in focus order */
+		updatetiled(m);
+		if(m->ntiled + 1 > size) {
+			size = MAX(m->ntiled + 1, 2 * size);
+			if(!(wins = realloc(wins, size * sizeof(Window))))
+				die("fatal: could not realloc() %u bytes\n", size * sizeof(Window));
+		}
+		wins[0] = m->barwin;
+		for(n = 1, c = m->stack; c; c = c->snext)
 			if(!c->isfloating && ISVISIBLE(c)) {
-				XConfigureWindow(dpy, c->win, CWSibling|CWStackMode, &wc);
-				wc.sibling = c->win;
+				if(c->win == m->raised)
+					m->raised = None;
+				wins[n++] = c->win;
 			}
+		restacktiled(m, wins, n);
+		if(n > m->stackedsize) {
+			m->stackedsize = MAX(n, 2 * m->stackedsize);
+			if(!(m->stacked = realloc(m->stacked, m->stackedsize * sizeof(Window))))
+				die("fatal: could not realloc() %u bytes\n", m->stackedsize * sizeof(Window));
+		}
+		memcpy(m->stacked, wins, n * sizeof(Window));
+		m->nstacked = n;
+	}
+	if((m->sel->isfloating || !m->lt[m->sellt]->arrange) && m->raised != m->sel->win) {
+		XRaiseWindow(dpy, m->sel->win);
+		m->raised = m->sel->win;
+		if(!m->sel->isfloating) /* a tiled client is out of its place */
+			m->nstacked = 0;
 	}
 	XSync(dpy, False);
 	while(XCheckMaskEvent(dpy, EnterWindowMask, &ev));
+	STATEND(sp, opstats[OpRestack], NextRequest(dpy));
+}
+
+static int
+cmpstackpos(const void *a, const void *b) {
+	const StackPos *pa = a, *pb = b;
+
+	return pa->win < pb->win ? -1 : pa->win > pb->win;
+}
+
+/* Moves the windows of the last restack of m into the order wins, bar first.
+ * The longest run of windows whose relative order is unchanged stays put and
+ * every other window goes below its new predecessor, so pulling one window to
+ * the front costs a single request. */
+void
+restacktiled(Monitor *m, Window *wins, unsigned int n) {
+	static StackPos *pos = NULL;
+	static unsigned int *idx = NULL, size = 0;
+	unsigned int *old, *tails, *prev, i, lo, hi, mid, len;
+	StackPos key, *p;
+	XWindowChanges wc;
+
+	if(!m->nstacked || m->stacked[0] != wins[0]) {
+		XRestackWindows(dpy, wins, n);
+		return;
+	}
+	for(i = 1; i < n && i < m->nstacked && wins[i] == m->stacked[i]; i++);
+	if(i == n)
+		return;
+	if(MAX(n, m->nstacked) > size) {
+		size = MAX(MAX(n, m->nstacked), 2 * size);
+		if(!(pos = realloc(pos, size * sizeof(StackPos))))
+			die("fatal: could not realloc() %u bytes\n", size * sizeof(StackPos));
+		if(!(idx = realloc(idx, 3 * size * sizeof(unsigned int))))
+			die("fatal: could not realloc() %u bytes\n", 3 * size * sizeof(unsigned int));
+	}
+	old = idx;
+	tails = idx + size;
+	prev = idx + 2 * size;
+	for(i = 0; i < m->nstacked; i++) {
+		pos[i].win = m->stacked[i];
+		pos[i].i = i;
+	}
+	qsort(pos, m->nstacked, sizeof(StackPos), cmpstackpos);
+	/* longest subsequence of wins that was already stacked in this order,
+	 * it always starts with the bar */
+	for(len = 0, i = 0; i < n; i++) {
+		key.win = wins[i];
+		p = bsearch(&key, pos, m->nstacked, sizeof(StackPos), cmpstackpos);
+		if(!p) {
+			old[i] = UINT_MAX;
+			continue;
+		}
+		old[i] = p->i;
+		for(lo = 0, hi = len; lo < hi;) {
+			mid = (lo + hi) / 2;
+			if(old[tails[mid]] < old[i])
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		prev[i] = lo ? tails[lo - 1] : UINT_MAX;
+		tails[lo] = i;
+		if(lo == len)
+			len++;
+	}
+	/* old[] now only marks the windows that stay */
+	for(i = 0; i < n; i++)
+		old[i] = 1;
+	for(i = tails[len - 1]; i != UINT_MAX; i = prev[i])
+		old[i] = 0;
+	wc.stack_mode = Below;
+	for(i = 1; i < n; i++)
+		if(old[i]) {
+			wc.sibling = wins[i - 1];
+			XConfigureWindow(dpy, wins[i], CWSibling|CWStackMode, &wc);
+		}
 }
 
 void
 run(void) {
-	XEvent ev;
+	int xfd = ConnectionNumber(dpy), maxfd;
+	fd_set rfds;
+	IpcClient *ic;
+
 	/* main event loop */
 	XSync(dpy, False);
-	while(running && !XNextEvent(dpy, &ev))
-		if(handler[ev.type])
-			handler[ev.type](&ev); /* call handler */
+	updatestate();
+	while(running) {
+#if defined(STATS) || defined(TRACE)
+		if(dumpstats) {
+			dumpstats = 0;
+			writestats();
+		}
+#endif /* STATS || TRACE */
+		if(!XPending(dpy)) {
+			FD_ZERO(&rfds);
+			FD_SET(xfd, &rfds);
+			if(fontfd >= 0)
+				FD_SET(fontfd, &rfds);
+			maxfd = MAX(xfd, fontfd);
+			if(ipcfd >= 0) {
+				FD_SET(ipcfd, &rfds);
+				maxfd = MAX(maxfd, ipcfd);
+				for(ic = ipcclients; ic; ic = ic->next)
+					if(ic->fd >= 0) {
+						FD_SET(ic->fd, &rfds);
+						maxfd = MAX(maxfd, ic->fd);
+					}
+			}
+			if(select(maxfd + 1, &rfds, NULL, NULL, NULL) < 0) {
+				if(errno == EINTR)
+					continue;
+				die("dwm: select failed\n");
+			}
+			if(fontfd >= 0 && FD_ISSET(fontfd, &rfds))
+				loadfont();
+			if(ipcfd >= 0)
+				ipcpoll(&rfds);
+		}
+		handleevents();
+	}
 }
 
 void
@@ -1472,8 +2835,10 @@ scan(void) {
 }
 
 void
-sendmon(Client *c, Monitor *m) {
-	if(c->mon == m)
+sendmon(Client *c, Monitor *m, Bool follow) {
+	Monitor *from = c->mon;
+
+	if(from == m)
 		return;
 	unfocus(c, True);
 	detach(c);
@@ -1482,8 +2847,12 @@ sendmon(Client *c, Monitor *m) {
 	c->tags = (m->tagset[m->seltags] ? m->tagset[m->seltags] : 1); /* assign tags of target monitor */
 	attach(c);
 	attachstack(c);
-	focus(NULL);
-	arrange(NULL);
+	if(follow)
+		selmon = m;
+	selectclient(NULL);
+	/* no other monitor is affected, restack() draws both bars */
+	arrange(from);
+	arrange(m);
 }
 
 void
@@ -1539,14 +2908,17 @@ setfullscreen(Client *c, Bool fullscreen) {
 		c->oldbw = c->bw;
 		c->bw = 0;
 		c->isfloating = True;
+		c->mon->tiledstale = True;
 		resizeclient(c, c->mon->mx, c->mon->my, c->mon->mw, c->mon->mh);
 		XRaiseWindow(dpy, c->win);
+		c->mon->raised = c->win;
 	}
 	else {
 		XChangeProperty(dpy, c->win, netatom[NetWMState], XA_ATOM, 32,
 		                PropModeReplace, (unsigned char*)0, 0);
 		c->isfullscreen = False;
 		c->isfloating = c->oldstate;
+		c->mon->tiledstale = True;
 		c->bw = c->oldbw;
 		c->x = c->oldx;
 		c->y = c->oldy;
@@ -1564,6 +2936,7 @@ setlayout(const Arg *arg) {
 	if(arg && arg->v)
 		selmon->lt[selmon->sellt] = (Layout *)arg->v;
 	strncpy(selmon->ltsymbol, selmon->lt[selmon->sellt]->symbol, sizeof selmon->ltsymbol);
+	selmon->nstacked = 0;
 	if(selmon->sel)
 		arrange(selmon);
 	else
@@ -1604,22 +2977,51 @@ setmfact(const Arg *arg) {
 	arrange(selmon);
 }
 
+/* Fills r with the geometry c would get from resize(), without touching
+ * the client itself. */
+void
+setrect(Client *c, Rect *r, int x, int y, int w, int h) {
+	applysizehints(c, &x, &y, &w, &h, False);
+	r->x = x;
+	r->y = y;
+	r->w = w;
+	r->h = h;
+}
+
 void
 setup(void) {
+	int i;
 	XSetWindowAttributes wa;
 
 	/* clean up any zombies immediately */
 	sigchld(0);
+#if defined(STATS) || defined(TRACE)
+	signal(SIGUSR1, sigusr1);
+#endif /* STATS || TRACE */
 
 	/* init screen */
 	screen = DefaultScreen(dpy);
 	root = RootWindow(dpy, screen);
-	fnt = drw_font_create(dpy, screen, font);
+#ifdef XRANDR
+	{
+		int major, minor;
+
+		/* 1.3 for XRRGetScreenResourcesCurrent() */
+		if(XRRQueryExtension(dpy, &rrevbase, &i) && XRRQueryVersion(dpy, &major, &minor)
+		&& (major > 1 || minor >= 3))
+			XRRSelectInput(dpy, root, RRScreenChangeNotifyMask
+			               | RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
+		else
+			rrevbase = -1;
+	}
+#endif /* XRANDR */
+	/* the font is created in run() once fontconfig is ready, until then
+	 * clients are managed with a provisional bar height */
+	fontfd = drw_font_preload();
 	sw = DisplayWidth(dpy, screen);
 	sh = DisplayHeight(dpy, screen);
-	bh = fnt->h + 6;
+	bh = drw_font_guessh(dpy, screen, font) + 6;
 	drw = drw_create(dpy, screen, root, sw, sh);
-	drw_setfont(drw, fnt);
 	updategeom();
 	/* init atoms */
 	wmatom[WMProtocols] = XInternAtom(dpy, "WM_PROTOCOLS", False);
@@ -1635,6 +3037,12 @@ setup(void) {
 	netatom[NetWMWindowType] = XInternAtom(dpy, "_NET_WM_WINDOW_TYPE", False);
 	netatom[NetWMWindowTypeDialog] = XInternAtom(dpy, "_NET_WM_WINDOW_TYPE_DIALOG", False);
 	netatom[NetClientList] = XInternAtom(dpy, "_NET_CLIENT_LIST", False);
+	netatom[NetClientListStacking] = XInternAtom(dpy, "_NET_CLIENT_LIST_STACKING", False);
+	netatom[NetWMSyncRequest] = XInternAtom(dpy, "_NET_WM_SYNC_REQUEST", False);
+	netatom[NetWMSyncRequestCounter] = XInternAtom(dpy, "_NET_WM_SYNC_REQUEST_COUNTER", False);
+	/* init extensions */
+	if(!XSyncQueryExtension(dpy, &syncevbase, &i) || !XSyncInitialize(dpy, &i, &i))
+		syncevbase = -1;
 	/* init cursors */
 	cursor[CurNormal] = drw_cur_create(drw, XC_left_ptr);
 	cursor[CurResize] = drw_cur_create(drw, XC_sizing);
@@ -1646,15 +3054,19 @@ setup(void) {
 	scheme[SchemeSel].border = drw_clr_create(drw, selbordercolor);
 	scheme[SchemeSel].bg = drw_clr_create(drw, selbgcolor);
 	scheme[SchemeSel].fg = drw_clr_create(drw, selfgcolor);
+	scheme[SchemeUrg].border = drw_clr_create(drw, urgfgcolor);
 	scheme[SchemeUrg].bg = drw_clr_create(drw, urgbgcolor);
 	scheme[SchemeUrg].fg = drw_clr_create(drw, urgfgcolor);
 	/* init bars */
 	updatebars();
 	updatestatus();
+	if(fontfd < 0)
+		loadfont();
 	/* EWMH support per view */
 	XChangeProperty(dpy, root, netatom[NetSupported], XA_ATOM, 32,
 			PropModeReplace, (unsigned char *) netatom, NetLast);
 	XDeleteProperty(dpy, root, netatom[NetClientList]);
+	XDeleteProperty(dpy, root, netatom[NetClientListStacking]);
 	/* select for events */
 	wa.cursor = cursor[CurNormal]->cursor;
 	wa.event_mask = SubstructureRedirectMask|SubstructureNotifyMask|ButtonPressMask|PointerMotionMask
@@ -1663,22 +3075,35 @@ setup(void) {
 	XSelectInput(dpy, root, wa.event_mask);
 	grabkeys();
 	focus(NULL);
+	ipcinit();
+	stateinit();
+#ifdef STATS
+	measureinit();
+#endif /* STATS */
 }
 
+/* Moves the clients of m on or off screen, only issuing requests for those
+ * whose visibility changed since the last call. */
 void
-showhide(Client *c) {
-	if(!c)
-		return;
-	if(ISVISIBLE(c)) { /* show clients top down */
-		XMoveWindow(dpy, c->win, c->x, c->y);
-		if((!c->mon->lt[c->mon->sellt]->arrange || c->isfloating) && !c->isfullscreen)
-			resize(c, c->x, c->y, c->w, c->h, False);
-		showhide(c->snext);
-	}
-	else { /* hide clients bottom up */
-		showhide(c->snext);
-		XMoveWindow(dpy, c->win, WIDTH(c) * -2, c->y);
-	}
+showhide(Monitor *m) {
+	Client *c;
+
+	/* show clients top down */
+	for(c = m->stack; c; c = c->snext)
+		if(ISVISIBLE(c)) {
+			if(c->ishidden) {
+				XMoveWindow(dpy, c->win, c->x, c->y);
+				c->ishidden = False;
+			}
+			if((!m->lt[m->sellt]->arrange || c->isfloating) && !c->isfullscreen)
+				resize(c, c->x, c->y, c->w, c->h, False);
+		}
+	/* hide clients bottom up */
+	for(c = m->stack ? m->stack->sprev : NULL; c; c = c == m->stack ? NULL : c->sprev)
+		if(!ISVISIBLE(c) && !c->ishidden) {
+			XMoveWindow(dpy, c->win, WIDTH(c) * -2, c->y);
+			c->ishidden = True;
+		}
 }
 
 void
@@ -1688,6 +3113,39 @@ sigchld(int unused) {
 	while(0 < waitpid(-1, NULL, WNOHANG));
 }
 
+#if defined(STATS) || defined(TRACE)
+void
+sigusr1(int unused) {
+	dumpstats = 1;
+}
+#endif /* STATS || TRACE */
+
+void
+stateinit(void) {
+	int fd;
+	void *p;
+
+	displaypath(statepath, sizeof statepath, statefile);
+	/* the directory is shared: never open what someone else put there,
+	 * O_EXCL also refuses to follow a symlink */
+	unlink(statepath);
+	if((fd = open(statepath, O_RDWR | O_CREAT | O_EXCL, 0600)) < 0) {
+		fprintf(stderr, "dwm: open %s", statepath);
+		perror(" failed");
+		return;
+	}
+	if(ftruncate(fd, sizeof(State)) < 0
+	|| (p = mmap(NULL, sizeof(State), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+	{
+		fprintf(stderr, "dwm: mmap %s", statepath);
+		perror(" failed");
+		unlink(statepath);
+	}
+	else
+		state = p;
+	close(fd);
+}
+
 void
 spawn(const Arg *arg) {
 	if(arg->v == dmenu)
@@ -1703,10 +3161,45 @@ spawn(const Arg *arg) {
 	}
 }
 
+/* Like resize() with interact set, but precedes the configure with a
+ * _NET_WM_SYNC_REQUEST if the client has an alarm set up by resizemouse().
+ * Returns True if the client is expected to acknowledge it. */
+Bool
+syncresize(Client *c, int x, int y, int w, int h, Time t) {
+	int overflow;
+	XEvent ev;
+	XSyncValue one;
+	XSyncAlarmAttributes aa;
+
+	if(!applysizehints(c, &x, &y, &w, &h, True))
+		return False;
+	if(!c->info->syncalarm) {
+		resizeclient(c, x, y, w, h);
+		return False;
+	}
+	XSyncIntToValue(&one, 1);
+	XSyncValueAdd(&c->info->syncvalue, c->info->syncvalue, one, &overflow);
+	ev.type = ClientMessage;
+	ev.xclient.window = c->win;
+	ev.xclient.message_type = wmatom[WMProtocols];
+	ev.xclient.format = 32;
+	ev.xclient.data.l[0] = netatom[NetWMSyncRequest];
+	ev.xclient.data.l[1] = t;
+	ev.xclient.data.l[2] = XSyncValueLow32(c->info->syncvalue);
+	ev.xclient.data.l[3] = XSyncValueHigh32(c->info->syncvalue);
+	ev.xclient.data.l[4] = 0;
+	XSendEvent(dpy, c->win, False, NoEventMask, &ev);
+	aa.trigger.wait_value = c->info->syncvalue;
+	XSyncChangeAlarm(dpy, c->info->syncalarm, XSyncCAValue, &aa);
+	resizeclient(c, x, y, w, h);
+	return True;
+}
+
 void
 tag(const Arg *arg) {
 	if(selmon->sel && arg->ui & TAGMASK) {
 		selmon->sel->tags = arg->ui & TAGMASK;
+		selmon->tiledstale = True;
 		focus(NULL);
 		arrange(selmon);
 	}
@@ -1716,41 +3209,39 @@ void
 tagmon(const Arg *arg) {
 	if(!selmon->sel || !mons->next)
 		return;
-	sendmon(selmon->sel, dirtomon(arg->i));
+	sendmon(selmon->sel, dirtomon(arg->i), False);
 }
 
 void
-tile(Monitor *m) {
-	unsigned int i, n, h, mw, my, ty;
+tile(Monitor *m, Client **c, unsigned int n, Rect *r) {
+	unsigned int i, h, mw, my, ty;
 	float mfacts = 0, sfacts = 0;
-	Client *c;
-
-	for(n = 0, c = nexttiled(m->clients); c; c = nexttiled(c->next), n++) {
-		if(n < m->nmaster)
-			mfacts += c->cfact;
-		else
-			sfacts += c->cfact;
-	}
 
 	if(n == 0)
 		return;
+	for(i = 0; i < n; i++) {
+		if(i < m->nmaster)
+			mfacts += c[i]->cfact;
+		else
+			sfacts += c[i]->cfact;
+	}
 
 	if(n > m->nmaster)
 		mw = m->nmaster ? m->ww * m->mfact : 0;
 	else
 		mw = m->ww;
-	for(i = my = ty = 0, c = nexttiled(m->clients); c; c = nexttiled(c->next), i++)
+	for(i = my = ty = 0; i < n; i++)
 		if(i < m->nmaster) {
-			h = (m->wh - my) * (c->cfact / mfacts);
-			resize(c, m->wx, m->wy + my, mw - (2*c->bw), h - (2*c->bw), False);
-			my += HEIGHT(c);
-			mfacts -= c->cfact;
+			h = (m->wh - my) * (c[i]->cfact / mfacts);
+			setrect(c[i], &r[i], m->wx, m->wy + my, mw - (2*c[i]->bw), h - (2*c[i]->bw));
+			my += r[i].h + 2 * c[i]->bw;
+			mfacts -= c[i]->cfact;
 		}
 		else {
-			h = (m->wh - ty) * (c->cfact / sfacts);
-			resize(c, m->wx + mw, m->wy + ty, m->ww - mw - (2*c->bw), h - (2*c->bw), False);
-			ty += HEIGHT(c);
-			sfacts -= c->cfact;
+			h = (m->wh - ty) * (c[i]->cfact / sfacts);
+			setrect(c[i], &r[i], m->wx + mw, m->wy + ty, m->ww - mw - (2*c[i]->bw), h - (2*c[i]->bw));
+			ty += r[i].h + 2 * c[i]->bw;
+			sfacts -= c[i]->cfact;
 		}
 }
 
@@ -1769,6 +3260,7 @@ togglefloating(const Arg *arg) {
 	if(selmon->sel->isfullscreen) /* no support for fullscreen windows */
 		return;
 	selmon->sel->isfloating = !selmon->sel->isfloating || selmon->sel->isfixed;
+	selmon->tiledstale = True;
 	if(selmon->sel->isfloating)
 		resize(selmon->sel, selmon->sel->x, selmon->sel->y,
 		       selmon->sel->w, selmon->sel->h, False);
@@ -1784,6 +3276,7 @@ toggletag(const Arg *arg) {
 	newtags = selmon->sel->tags ^ (arg->ui & TAGMASK);
 	if(newtags) {
 		selmon->sel->tags = newtags;
+		selmon->tiledstale = True;
 		focus(NULL);
 		arrange(selmon);
 	}
@@ -1794,6 +3287,7 @@ toggleview(const Arg *arg) {
 	unsigned int newtagset = selmon->tagset[selmon->seltags] ^ (arg->ui & TAGMASK);
 
 	selmon->tagset[selmon->seltags] = newtagset;
+	selmon->tiledstale = True;
 	focus(NULL);
 	arrange(selmon);
 }
@@ -1814,7 +3308,9 @@ void
 unmanage(Client *c, Bool destroyed) {
 	Monitor *m = c->mon;
 	XWindowChanges wc;
+	STATSPAN(sp);
 
+	STATBEGIN(sp, NextRequest(dpy), c->win, m->num);
 	/* The server grab construct avoids race conditions. */
 	detach(c);
 	detachstack(c);
@@ -1829,10 +3325,11 @@ unmanage(Client *c, Bool destroyed) {
 		XSetErrorHandler(xerror);
 		XUngrabServer(dpy);
 	}
-	free(c);
+	freeclient(c);
 	focus(NULL);
 	updateclientlist();
 	arrange(m);
+	STATEND(sp, opstats[OpUnmanage], NextRequest(dpy));
 }
 
 void
@@ -1864,6 +3361,7 @@ updatebars(void) {
 		                          CWOverrideRedirect|CWBackPixmap|CWEventMask, &wa);
 		XDefineCursor(dpy, m->barwin, cursor[CurNormal]->cursor);
 		XMapRaised(dpy, m->barwin);
+		m->raised = None;
 	}
 }
 
@@ -1881,22 +3379,137 @@ updatebarpos(Monitor *m) {
 }
 
 void
-updateclientlist() {
+updateclientlist(void) {
+	static Window *wins = NULL;
+	static unsigned int size = 0;
+	unsigned int i, n;
 	Client *c;
 	Monitor *m;
 
-	XDeleteProperty(dpy, root, netatom[NetClientList]);
-	for(m = mons; m; m = m->next)
+	for(n = 0, m = mons; m; m = m->next)
+		for(c = m->clients; c; c = c->next, n++);
+	if(n > size) {
+		size = MAX(n, 2 * size);
+		if(!(wins = realloc(wins, size * sizeof(Window))))
+			die("fatal: could not realloc() %u bytes\n", size * sizeof(Window));
+	}
+	for(i = 0, m = mons; m; m = m->next)
 		for(c = m->clients; c; c = c->next)
-			XChangeProperty(dpy, root, netatom[NetClientList],
-			                XA_WINDOW, 32, PropModeAppend,
-			                (unsigned char *) &(c->win), 1);
+			wins[i++] = c->win;
+	updatewinlist(netatom[NetClientList], &clientlist, wins, n);
+	/* _NET_CLIENT_LIST_STACKING is bottom-to-top, the focus stack top-down */
+	for(m = mons; m; m = m->next)
+		for(c = m->stack; c; c = c->snext)
+			wins[--i] = c->win;
+	updatewinlist(netatom[NetClientListStacking], &stackinglist, wins, n);
+}
+
+/* Publishes wins as prop with a single write, unless it equals the
+ * previously published list l. */
+void
+updatewinlist(Atom prop, WinList *l, Window *wins, unsigned int n) {
+	if(n == l->n && (!n || !memcmp(l->wins, wins, n * sizeof(Window))))
+		return;
+	if(n > l->size) {
+		l->size = MAX(n, 2 * l->size);
+		if(!(l->wins = realloc(l->wins, l->size * sizeof(Window))))
+			die("fatal: could not realloc() %u bytes\n", l->size * sizeof(Window));
+	}
+	memcpy(l->wins, wins, n * sizeof(Window));
+	l->n = n;
+	XChangeProperty(dpy, root, prop, XA_WINDOW, 32, PropModeReplace,
+	                (unsigned char *)l->wins, n);
 }
 
 Bool
 updategeom(void) {
 	Bool dirty = False;
 
+#ifdef XRANDR
+	if(rrevbase >= 0) {
+		int i, n;
+		Client *c;
+		Monitor *m, *o, *next, *target;
+		XRRScreenResources *res = XRRGetScreenResourcesCurrent(dpy, root);
+		XRRCrtcInfo *ci;
+
+		/* one monitor per active CRTC, matched by the CRTC's first output
+		 * so that monitors keep their clients when others come and go */
+		for(m = mons; m; m = m->next)
+			m->present = False;
+		for(i = 0; res && i < res->ncrtc; i++) {
+			if(!(ci = XRRGetCrtcInfo(dpy, res, res->crtcs[i])))
+				continue;
+			if(ci->noutput > 0 && ci->width > 0 && ci->height > 0) {
+				/* clones on separate CRTCs count as one screen */
+				for(o = mons; o && !(o->present && o->mx == ci->x && o->my == ci->y
+				    && o->mw == (int)ci->width && o->mh == (int)ci->height); o = o->next);
+				for(m = mons; m && m->output != ci->outputs[0]; m = m->next);
+				if(!o && !m) {
+					for(m = mons; m && m->next; m = m->next);
+					if(m)
+						m = m->next = createmon();
+					else
+						m = mons = createmon();
+					m->output = ci->outputs[0];
+				}
+				if(!o && m && !m->present) {
+					m->present = True;
+					if(ci->x != m->mx || ci->y != m->my
+					|| (int)ci->width != m->mw || (int)ci->height != m->mh)
+					{
+						dirty = True;
+						m->dirty = True;
+						m->mx = m->wx = ci->x;
+						m->my = m->wy = ci->y;
+						m->mw = m->ww = ci->width;
+						m->mh = m->wh = ci->height;
+						updatebarpos(m);
+					}
+				}
+			}
+			XRRFreeCrtcInfo(ci);
+		}
+		if(res)
+			XRRFreeScreenResources(res);
+		for(target = mons; target && !target->present; target = target->next);
+		if(!target) { /* no active output, keep one monitor covering the screen */
+			if(!mons)
+				mons = createmon();
+			target = mons;
+			target->present = True;
+			if(target->mx != 0 || target->my != 0 || target->mw != sw || target->mh != sh) {
+				dirty = True;
+				target->dirty = True;
+				target->mx = target->wx = target->my = target->wy = 0;
+				target->mw = target->ww = sw;
+				target->mh = target->wh = sh;
+				updatebarpos(target);
+			}
+		}
+		/* hand the clients of vanished monitors to the first remaining one */
+		for(m = mons; m; m = next) {
+			next = m->next;
+			if(m->present)
+				continue;
+			dirty = True;
+			target->dirty = True;
+			while((c = m->clients)) {
+				detach(c);
+				detachstack(c);
+				c->mon = target;
+				attach(c);
+				attachstack(c);
+			}
+			if(m == selmon)
+				selmon = target;
+			cleanupmon(m);
+		}
+		for(n = 0, m = mons; m; m = m->next, n++)
+			m->num = n;
+	}
+	else
+#endif /* XRANDR */
 #ifdef XINERAMA
 	if(XineramaIsActive(dpy)) {
 		int i, j, n, nn;
@@ -1928,6 +3541,7 @@ updategeom(void) {
 				    || unique[i].width != m->mw || unique[i].height != m->mh))
 				{
 					dirty = True;
+					m->dirty = True;
 					m->num = i;
 					m->mx = m->wx = unique[i].x_org;
 					m->my = m->wy = unique[i].y_org;
@@ -1939,10 +3553,10 @@ updategeom(void) {
 		else { /* less monitors available nn < n */
 			for(i = nn; i < n; i++) {
 				for(m = mons; m && m->next; m = m->next);
-				while(m->clients) {
+				while((c = m->clients)) {
 					dirty = True;
-					c = m->clients;
-					m->clients = c->next;
+					mons->dirty = True;
+					detach(c);
 					detachstack(c);
 					c->mon = mons;
 					attach(c);
@@ -1963,11 +3577,13 @@ updategeom(void) {
 			mons = createmon();
 		if(mons->mw != sw || mons->mh != sh) {
 			dirty = True;
+			mons->dirty = True;
 			mons->mw = mons->ww = sw;
 			mons->mh = mons->wh = sh;
 			updatebarpos(mons);
 		}
 	}
+	updatemonindex();
 	if(dirty) {
 		selmon = mons;
 		selmon = wintomon(root);
@@ -1975,6 +3591,27 @@ updategeom(void) {
 	return dirty;
 }
 
+static int
+cmpmon(const void *a, const void *b) {
+	const Monitor *ma = *(Monitor * const *)a, *mb = *(Monitor * const *)b;
+
+	return ma->mx != mb->mx ? ma->mx - mb->mx : ma->my - mb->my;
+}
+
+void
+updatemonindex(void) {
+	unsigned int n;
+	Monitor *m;
+
+	for(n = 0, m = mons; m; m = m->next, n++);
+	if(!(monindex = realloc(monindex, n * sizeof(Monitor *))))
+		die("fatal: could not realloc() %u bytes\n", n * sizeof(Monitor *));
+	for(n = 0, m = mons; m; m = m->next)
+		monindex[n++] = m;
+	qsort(monindex, n, sizeof(Monitor *), cmpmon);
+	nmonindex = n;
+}
+
 void
 updatenumlockmask(void) {
 	unsigned int i, j;
@@ -1994,58 +3631,151 @@ void
 updatesizehints(Client *c) {
 	long msize;
 	XSizeHints size;
+	ClientInfo *ci = c->info;
+	float mina = ci->mina, maxa = ci->maxa;
+	int basew = ci->basew, baseh = ci->baseh, incw = ci->incw, inch = ci->inch;
+	int maxw = ci->maxw, maxh = ci->maxh, minw = ci->minw, minh = ci->minh;
 
 	if(!XGetWMNormalHints(dpy, c->win, &size, &msize))
 		/* size is uninitialized, ensure that size.flags aren't used */
 		size.flags = PSize;
 	if(size.flags & PBaseSize) {
-		c->basew = size.base_width;
-		c->baseh = size.base_height;
+		c->info->basew = size.base_width;
+		c->info->baseh = size.base_height;
 	}
 	else if(size.flags & PMinSize) {
-		c->basew = size.min_width;
-		c->baseh = size.min_height;
+		c->info->basew = size.min_width;
+		c->info->baseh = size.min_height;
 	}
 	else
-		c->basew = c->baseh = 0;
+		c->info->basew = c->info->baseh = 0;
 	if(size.flags & PResizeInc) {
-		c->incw = size.width_inc;
-		c->inch = size.height_inc;
+		c->info->incw = size.width_inc;
+		c->info->inch = size.height_inc;
 	}
 	else
-		c->incw = c->inch = 0;
+		c->info->incw = c->info->inch = 0;
 	if(size.flags & PMaxSize) {
-		c->maxw = size.max_width;
-		c->maxh = size.max_height;
+		c->info->maxw = size.max_width;
+		c->info->maxh = size.max_height;
 	}
 	else
-		c->maxw = c->maxh = 0;
+		c->info->maxw = c->info->maxh = 0;
 	if(size.flags & PMinSize) {
-		c->minw = size.min_width;
-		c->minh = size.min_height;
+		c->info->minw = size.min_width;
+		c->info->minh = size.min_height;
 	}
 	else if(size.flags & PBaseSize) {
-		c->minw = size.base_width;
-		c->minh = size.base_height;
+		c->info->minw = size.base_width;
+		c->info->minh = size.base_height;
 	}
 	else
-		c->minw = c->minh = 0;
+		c->info->minw = c->info->minh = 0;
 	if(size.flags & PAspect) {
-		c->mina = (float)size.min_aspect.y / size.min_aspect.x;
-		c->maxa = (float)size.max_aspect.x / size.max_aspect.y;
+		c->info->mina = (float)size.min_aspect.y / size.min_aspect.x;
+		c->info->maxa = (float)size.max_aspect.x / size.max_aspect.y;
 	}
 	else
-		c->maxa = c->mina = 0.0;
-	c->isfixed = (c->maxw && c->minw && c->maxh && c->minh
-	             && c->maxw == c->minw && c->maxh == c->minh);
+		c->info->maxa = c->info->mina = 0.0;
+	c->isfixed = (c->info->maxw && c->info->minw && c->info->maxh && c->info->minh
+	             && c->info->maxw == c->info->minw && c->info->maxh == c->info->minh);
+	/* hints are applied to tiled geometry */
+	if(mina != ci->mina || maxa != ci->maxa
+	|| basew != ci->basew || baseh != ci->baseh || incw != ci->incw || inch != ci->inch
+	|| maxw != ci->maxw || maxh != ci->maxh || minw != ci->minw || minh != ci->minh)
+		layoutgen++;
+}
+
+void
+updatesynccounter(Client *c) {
+	int di, n;
+	unsigned long dl;
+	unsigned char *p = NULL;
+	Atom da, *protocols;
+	Bool exists = False;
+
+	c->info->synccounter = None;
+	if(syncevbase < 0 || !XGetWMProtocols(dpy, c->win, &protocols, &n))
+		return;
+	while(!exists && n--)
+		exists = protocols[n] == netatom[NetWMSyncRequest];
+	XFree(protocols);
+	if(exists && XGetWindowProperty(dpy, c->win, netatom[NetWMSyncRequestCounter], 0L, 1L, False,
+	                                XA_CARDINAL, &da, &di, &dl, &dl, &p) == Success && p) {
+		c->info->synccounter = *(XSyncCounter *)p;
+		XFree(p);
+	}
 }
 
 void
 updatetitle(Client *c) {
-	if(!gettextprop(c->win, netatom[NetWMName], c->name, sizeof c->name))
-		gettextprop(c->win, XA_WM_NAME, c->name, sizeof c->name);
-	if(c->name[0] == '\0') /* hack to mark broken clients */
-		strcpy(c->name, broken);
+	if(!gettextprop(c->win, netatom[NetWMName], c->info->name, sizeof c->info->name))
+		gettextprop(c->win, XA_WM_NAME, c->info->name, sizeof c->info->name);
+	if(c->info->name[0] == '\0') /* hack to mark broken clients */
+		strcpy(c->info->name, broken);
+}
+
+/* Applies queued screen changes. Only the bars of monitors whose geometry
+ * changed are moved and only those monitors are re-arranged. */
+void
+updatescreen(void) {
+	Monitor *m;
+
+	screenstale = False;
+	if(drw->w != (unsigned int)sw)
+		drw_resize(drw, sw, bh);
+	if(!updategeom())
+		return;
+	updatebars();
+	for(m = mons; m; m = m->next)
+		if(m->dirty) {
+			XMoveResizeWindow(dpy, m->barwin, m->wx, m->by, m->ww, bh);
+			arrange(m);
+			m->dirty = False;
+		}
+	focus(NULL);
+}
+
+/* Publishes the snapshot described in state.h if it changed. */
+void
+updatestate(void) {
+	const size_t off = offsetof(State, version);
+	uint32_t n;
+	State next;
+	StateMon *sm;
+	Client *c;
+	Monitor *m;
+
+	if(!state)
+		return;
+	memset(&next, 0, sizeof next);
+	next.version = STATEVERSION;
+	next.size = sizeof(State);
+	next.selmon = selmon->num;
+	for(n = 0, m = mons; m && n < STATEMONS; m = m->next, n++) {
+		sm = &next.mons[n];
+		sm->num = m->num;
+		sm->x = m->mx;
+		sm->y = m->my;
+		sm->w = m->mw;
+		sm->h = m->mh;
+		sm->tags = m->tagset[m->seltags];
+		for(c = m->clients; c; c = c->next, sm->nclients++) {
+			sm->occ |= c->tags;
+			if(c->isurgent)
+				sm->urg |= c->tags;
+		}
+		sm->sel = m->sel ? m->sel->win : None;
+		memcpy(sm->ltsymbol, m->ltsymbol, sizeof sm->ltsymbol);
+	}
+	next.nmons = n;
+	if(!memcmp((char *)&next + off, (char *)state + off, sizeof next - off))
+		return;
+	state->seq++;
+	__sync_synchronize();
+	memcpy((char *)state + off, (char *)&next + off, sizeof next - off);
+	__sync_synchronize();
+	state->seq++;
 }
 
 void
@@ -2054,6 +3784,32 @@ updatestatus(void) {
 	drawbars();
 }
 
+/* Rebuilds the array of visible tiled clients, if anything it depends on
+ * changed since it was last built. */
+void
+updatetiled(Monitor *m) {
+	unsigned int n;
+	Client *c;
+
+	if(!m->tiledstale)
+		return;
+	for(n = m->nvisible = 0, c = m->clients; c; c = c->next)
+		if(ISVISIBLE(c)) {
+			m->nvisible++;
+			if(!c->isfloating)
+				n++;
+		}
+	if(n > m->tiledsize) {
+		m->tiledsize = MAX(n, 2 * m->tiledsize);
+		if(!(m->tiled = realloc(m->tiled, m->tiledsize * sizeof(Client *))))
+			die("fatal: could not realloc() %u bytes\n", m->tiledsize * sizeof(Client *));
+	}
+	for(n = 0, c = nexttiled(m->clients); c; c = nexttiled(c->next))
+		m->tiled[n++] = c;
+	m->ntiled = n;
+	m->tiledstale = False;
+}
+
 void
 updatewindowtype(Client *c) {
 	Atom state = getatomprop(c, netatom[NetWMState]);
@@ -2061,8 +3817,10 @@ updatewindowtype(Client *c) {
 
 	if(state == netatom[NetWMFullscreen])
 		setfullscreen(c, True);
-	if(wtype == netatom[NetWMWindowTypeDialog])
+	if(wtype == netatom[NetWMWindowTypeDialog]) {
 		c->isfloating = True;
+		c->mon->tiledstale = True;
+	}
 }
 
 void
@@ -2094,6 +3852,7 @@ view(const Arg *arg) {
 	selmon->seltags ^= 1; /* toggle sel tagset */
 	if(arg->ui & TAGMASK)
 		selmon->tagset[selmon->seltags] = arg->ui & TAGMASK;
+	selmon->tiledstale = True;
 	focus(NULL);
 	arrange(selmon);
 }
@@ -2117,7 +3876,7 @@ wintomon(Window w) {
 	Monitor *m;
 
 	if(w == root && getrootptr(&x, &y))
-		return recttomon(x, y, 1, 1);
+		return pointtomon(x, y);
 	for(m = mons; m; m = m->next)
 		if(w == m->barwin)
 			return m;
@@ -2126,12 +3885,55 @@ wintomon(Window w) {
 	return selmon;
 }
 
+#if defined(STATS) || defined(TRACE)
+void
+writestats(void) {
+	char path[256];
+	FILE *f;
+
+#ifdef STATS
+	displaypath(path, sizeof path, statsfile);
+	if(!(f = fopen(path, "w"))) {
+		fprintf(stderr, "dwm: fopen %s", path);
+		perror(" failed");
+	}
+	else {
+		fprintf(f, "X requests %lu, round trips %lu\n\n", NextRequest(dpy) - 1, stats_roundtrips);
+		stats_dump(f, "event", evstats, LENGTH(evstats));
+		fputc('\n', f);
+		stats_dump(f, "operation", opstats, LENGTH(opstats));
+		fputc('\n', f);
+		stats_dump(f, "pango", drwstats, LENGTH(drwstats));
+		fputs("\ninput to settle, see measure()\n", f);
+		stats_dump(f, "key", keysettle, LENGTH(keysettle));
+		stats_dump(f, "button", buttonsettle, LENGTH(buttonsettle));
+		fputs("\nbinding dispatch\n", f);
+		stats_dump(f, "key", keydispatch, LENGTH(keydispatch));
+		stats_dump(f, "button", buttondispatch, LENGTH(buttondispatch));
+		fclose(f);
+	}
+#endif /* STATS */
+#ifdef TRACE
+	displaypath(path, sizeof path, tracefile);
+	if(!(f = fopen(path, "w"))) {
+		fprintf(stderr, "dwm: fopen %s", path);
+		perror(" failed");
+	}
+	else {
+		stats_trace(f);
+		fclose(f);
+	}
+#endif /* TRACE */
+}
+#endif /* STATS || TRACE */
+
 /* There's no way to check accesses to destroyed windows, thus those cases are
  * ignored (especially on UnmapNotify's).  Other types of errors call Xlibs
  * default error handler, which may call exit.  */
 int
 xerror(Display *dpy, XErrorEvent *ee) {
 	if(ee->error_code == BadWindow
+	|| (ee->request_code == X_GetAtomName && ee->error_code == BadAtom)
 	|| (ee->request_code == X_SetInputFocus && ee->error_code == BadMatch)
 	|| (ee->request_code == X_PolyText8 && ee->error_code == BadDrawable)
 	|| (ee->request_code == X_PolyFillRectangle && ee->error_code == BadDrawable)
@@ -2166,9 +3968,11 @@ zoom(const Arg *arg) {
 	if(!selmon->lt[selmon->sellt]->arrange
 	|| (selmon->sel && selmon->sel->isfloating))
 		return;
-	if(c == nexttiled(selmon->clients))
-		if(!c || !(c = nexttiled(c->next)))
-			return;
+	updatetiled(selmon);
+	if(selmon->ntiled && c == selmon->tiled[0])
+		c = selmon->ntiled > 1 ? selmon->tiled[1] : NULL;
+	if(!c)
+		return;
 	pop(c);
 }
 
@@ -2187,6 +3991,9 @@ main(int argc, char *argv[]) {
 	scan();
 	run();
 	cleanup();
+#if defined(STATS) || defined(TRACE)
+	writestats();
+#endif /* STATS || TRACE */
 	XCloseDisplay(dpy);
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,377 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Micro-benchmark of dwm's layouts. tile, bstack and monocle arrange
+ * synthetic clients on a synthetic monitor across client counts, nmaster and
+ * mfact settings, cfact distributions and size hint mixes; applysizehints is
+ * timed on its own. Each case prints a JSON line with the time per call and
+ * what a check of the result found:
+ *	overlaps  neighbours sharing pixels, or a client reaching into the
+ *	          other column
+ *	gaps      neighbours or column edges with unused pixels between them,
+ *	          gap_px in total
+ *	outside   clients reaching past the window area
+ *	slack_px  pixels left unused (or overrun) at the end of the columns
+ *	drift_px  largest distance of a client's far edge from where exact
+ *	          arithmetic on the cfacts would put it
+ * The layouts run on the fake Xlib of mockx.c, no display is needed.
+ *
+ * usage: dwm-layout [-n clients] [tile|bstack|monocle|applysizehints ...]
+ */
+#include <time.h>
+
+/* the benchmark needs dwm's internals, its main() is not used */
+#define main dwmmain
+#include "dwm.c"
+#undef main
+
+#define MINTIME                 0.01 /* seconds each case is timed for */
+#define SCREENW                 1920
+#define SCREENH                 1080
+#define BARH                    18
+
+enum { HintsNone, HintsTerm, HintsMixed, HintsLast };
+enum { CfactEqual, CfactSteps, CfactTenths, CfactLast };
+
+typedef struct {
+	const char *name;
+	void (*arrange)(Monitor *, Client **, unsigned int, Rect *);
+	Bool transposed;           /* clients stack along x rather than y */
+} Arrange;
+
+typedef struct {
+	int nmaster;
+	float mfact;
+} Split;
+
+typedef struct {
+	unsigned int overlaps, gaps, outside;
+	long gappx, slack;
+	double drift;
+} Check;
+
+/* function declarations */
+static void benchhints(int hints);
+static void benchlayout(const Arrange *a, unsigned int n, const Split *s, int cfacts, int hints);
+static void checkmonocle(Monitor *m, Client **c, unsigned int n, Rect *r, Check *k);
+static void checkstack(Monitor *m, Client **c, unsigned int n, Rect *r, Bool transposed, Check *k);
+static double now(void);
+static unsigned int rnd(void);
+static void setclients(unsigned int n, int cfacts, int hints);
+static void sethints(Client *c, unsigned int i, int hints);
+static Bool wanted(const char *name);
+
+/* variables */
+static const Arrange arranges[] = {
+	/* name        function  transposed */
+	{ "tile",      tile,     False },
+	{ "bstack",    bstack,   True },
+	{ "monocle",   monocle,  False },
+};
+static const Split splits[] = {
+	/* nmaster  mfact */
+	{ 1,        mfact },
+	{ 0,        mfact },
+	{ 3,        0.5 },
+};
+static const unsigned int counts[] = { 1, 4, 16, 100, 1000, 10000 };
+static const char *hintnames[] = { "none", "term", "mixed" };
+static const char *cfactnames[] = { "equal", "steps", "tenths" };
+static Monitor *mon;
+static Client *clients, **tiled;
+static ClientInfo *infos;
+static Rect *rects;
+static char **names;
+static int nnames;
+static unsigned int seed = 1;
+static volatile int sink;
+
+/* function implementations */
+void
+benchhints(int hints) {
+	static int w[1000], h[1000];
+	unsigned int i, n = LENGTH(w), reps, calls = 0, violations = 0;
+	int x, y, ww, hh;
+	double t;
+	Client *c;
+	ClientInfo *ci;
+
+	setclients(n, CfactEqual, hints);
+	for(i = 0; i < n; i++) {
+		w[i] = 1 + rnd() % SCREENW;
+		h[i] = 1 + rnd() % SCREENH;
+	}
+	for(i = 0; i < n; i++) {
+		c = &clients[i];
+		ci = c->info;
+		x = 0, y = mon->wy, ww = w[i], hh = h[i];
+		applysizehints(c, &x, &y, &ww, &hh, False);
+		if((ci->minw && ww < ci->minw) || (ci->maxw && ww > ci->maxw)
+		|| (ci->minh && hh < ci->minh) || (ci->maxh && hh > ci->maxh)
+		|| (ci->incw && ww != ci->minw && ww != ci->maxw && (ww - ci->basew) % ci->incw)
+		|| (ci->inch && hh != ci->minh && hh != ci->maxh && (hh - ci->baseh) % ci->inch))
+			violations++;
+	}
+	for(reps = 1;; reps *= 2) {
+		t = now();
+		for(calls = 0; calls < reps * n; calls++) {
+			x = 0, y = mon->wy, ww = w[calls % n], hh = h[calls % n];
+			sink += applysizehints(&clients[calls % n], &x, &y, &ww, &hh, False);
+		}
+		if((t = now() - t) >= MINTIME)
+			break;
+	}
+	printf("{\"function\":\"applysizehints\",\"hints\":\"%s\",\"calls\":%u,"
+	       "\"ns\":%.1f,\"violations\":%u}\n", hintnames[hints], calls, t * 1e9 / calls, violations);
+}
+
+void
+benchlayout(const Arrange *a, unsigned int n, const Split *s, int cfacts, int hints) {
+	unsigned int i, reps;
+	double t;
+	Check k;
+
+	setclients(n, cfacts, hints);
+	mon->nmaster = s->nmaster;
+	mon->mfact = s->mfact;
+	for(i = 0; i < n; i++)
+		tiled[i] = &clients[i];
+	for(reps = 1;; reps *= 2) {
+		t = now();
+		for(i = 0; i < reps; i++)
+			a->arrange(mon, tiled, n, rects);
+		if((t = now() - t) >= MINTIME)
+			break;
+	}
+	t = t * 1e9 / reps;
+	memset(&k, 0, sizeof k);
+	if(a->arrange == monocle)
+		checkmonocle(mon, tiled, n, rects, &k);
+	else
+		checkstack(mon, tiled, n, rects, a->transposed, &k);
+	printf("{\"layout\":\"%s\",\"clients\":%u,\"nmaster\":%d,\"mfact\":%.2f,"
+	       "\"cfact\":\"%s\",\"hints\":\"%s\",\"ns\":%.1f,\"ns_client\":%.2f,"
+	       "\"overlaps\":%u,\"gaps\":%u,\"gap_px\":%ld,\"outside\":%u,"
+	       "\"slack_px\":%ld,\"drift_px\":%.2f}\n",
+	       a->name, n, s->nmaster, s->mfact, cfactnames[cfacts], hintnames[hints],
+	       t, t / n, k.overlaps, k.gaps, k.gappx, k.outside, k.slack, k.drift);
+}
+
+/* every client should cover the window area exactly */
+void
+checkmonocle(Monitor *m, Client **c, unsigned int n, Rect *r, Check *k) {
+	unsigned int i;
+	int w, h;
+
+	for(i = 0; i < n; i++) {
+		w = r[i].w + 2 * c[i]->bw;
+		h = r[i].h + 2 * c[i]->bw;
+		if(r[i].x < m->wx || r[i].y < m->wy || r[i].x + w > m->wx + m->ww
+		|| r[i].y + h > m->wy + m->wh)
+			k->outside++;
+		else if(w < m->ww || h < m->wh) {
+			k->gaps++;
+			k->gappx += (long)m->ww * m->wh - (long)w * h;
+		}
+	}
+}
+
+/* Walks the columns of tile, or the rows of bstack read transposed: each
+ * client should start where its predecessor ended, fill its column across
+ * and the last one should end at the edge of the window area. */
+void
+checkstack(Monitor *m, Client **c, unsigned int n, Rect *r, Bool transposed, Check *k) {
+	unsigned int i, col, split;
+	int start = transposed ? m->wx : m->wy, size = transposed ? m->ww : m->wh;
+	int cross = transposed ? m->wy : m->wx, crosssize = transposed ? m->wh : m->ww;
+	int pos, s, e, x0, x1, cstart, cend;
+	float total, sum;
+	double d;
+
+	/* column boundary as the layouts compute it */
+	if(n > m->nmaster)
+		split = m->nmaster ? crosssize * m->mfact : 0;
+	else
+		split = crosssize;
+	for(col = 0; col < 2; col++) {
+		cstart = col ? cross + split : cross;
+		cend = col ? cross + crosssize : cross + split;
+		for(i = 0, total = 0; i < n; i++)
+			if((i < m->nmaster) == !col)
+				total += c[i]->cfact;
+		if(total == 0)
+			continue;
+		for(i = 0, pos = start, sum = 0; i < n; i++) {
+			if((i < m->nmaster) != !col)
+				continue;
+			s = transposed ? r[i].x : r[i].y;
+			e = s + (transposed ? r[i].w : r[i].h) + 2 * c[i]->bw;
+			x0 = transposed ? r[i].y : r[i].x;
+			x1 = x0 + (transposed ? r[i].h : r[i].w) + 2 * c[i]->bw;
+			if(s < pos)
+				k->overlaps++;
+			else if(s > pos) {
+				k->gaps++;
+				k->gappx += s - pos;
+			}
+			if(s < start || e > start + size || x0 < cross || x1 > cross + crosssize)
+				k->outside++;
+			else if(x0 < cstart || x1 > cend)
+				k->overlaps++;
+			else if(x0 > cstart || x1 < cend) {
+				k->gaps++;
+				k->gappx += (x0 - cstart) + (cend - x1);
+			}
+			sum += c[i]->cfact;
+			d = e - (start + (double)size * sum / total);
+			if(d < 0)
+				d = -d;
+			if(d > k->drift)
+				k->drift = d;
+			pos = e;
+		}
+		k->slack += start + size > pos ? start + size - pos : pos - start - size;
+	}
+}
+
+double
+now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* the same sequence on every run and system */
+unsigned int
+rnd(void) {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16 & 0x7fff;
+}
+
+void
+setclients(unsigned int n, int cfacts, int hints) {
+	static unsigned int size;
+	unsigned int i;
+
+	if(n > size) {
+		free(clients);
+		free(infos);
+		free(tiled);
+		free(rects);
+		if(!(clients = calloc(n, sizeof(Client))) || !(infos = calloc(n, sizeof(ClientInfo)))
+		|| !(tiled = calloc(n, sizeof(Client *))) || !(rects = calloc(n, sizeof(Rect))))
+			die("fatal: could not malloc() %u bytes\n", n * sizeof(Client));
+		size = n;
+	}
+	seed = 1;
+	for(i = 0; i < n; i++) {
+		memset(&clients[i], 0, sizeof(Client));
+		clients[i].win = i + 1;
+		clients[i].mon = mon;
+		clients[i].tags = 1;
+		clients[i].bw = borderpx;
+		clients[i].info = &infos[i];
+		switch(cfacts) {
+		case CfactEqual:  clients[i].cfact = 1.0; break;
+		case CfactSteps:  clients[i].cfact = 0.25 * (1 + rnd() % 16); break;
+		case CfactTenths: clients[i].cfact = 0.1 * (1 + rnd() % 20); break;
+		}
+		sethints(&clients[i], i, hints);
+	}
+}
+
+/* Gives clients size hints as a terminal (base size and increments) or a mix
+ * of terminals and windows with minimum, maximum and aspect limits. Hinted
+ * clients are marked floating so that applysizehints() honours the hints
+ * whatever resizehints is set to; the layouts do not look at isfloating. */
+void
+sethints(Client *c, unsigned int i, int hints) {
+	ClientInfo *ci = c->info;
+
+	memset(ci, 0, sizeof(ClientInfo));
+	if(hints == HintsNone)
+		return;
+	c->isfloating = True;
+	if(hints == HintsTerm || i % 3 == 0) {
+		ci->basew = ci->minw = 4;
+		ci->baseh = ci->minh = 4;
+		ci->incw = 7;
+		ci->inch = 15;
+	}
+	if(hints == HintsMixed) {
+		if(i % 5 == 1) {
+			ci->minw = 300;
+			ci->minh = 200;
+		}
+		if(i % 7 == 2) {
+			ci->mina = 3.0 / 4; /* 4:3 to 16:9 */
+			ci->maxa = 16.0 / 9;
+		}
+		if(i % 11 == 4) {
+			ci->maxw = 640;
+			ci->maxh = 480;
+		}
+	}
+	c->isfixed = ci->maxw && ci->minw && ci->maxh && ci->minh
+	             && ci->maxw == ci->minw && ci->maxh == ci->minh;
+}
+
+Bool
+wanted(const char *name) {
+	int i;
+
+	for(i = 0; i < nnames; i++)
+		if(!strcmp(names[i], name))
+			return True;
+	return !nnames;
+}
+
+int
+main(int argc, char *argv[]) {
+	unsigned int i, j, k, n = 0, count;
+	int cfacts, hints;
+
+	if(argc > 2 && !strcmp(argv[1], "-n")) {
+		if(!(n = atoi(argv[2])))
+			die("usage: dwm-layout [-n clients] [tile|bstack|monocle|applysizehints ...]\n");
+		argc -= 2, argv += 2;
+	}
+	names = argv + 1;
+	nnames = argc - 1;
+	sw = SCREENW;
+	sh = SCREENH;
+	bh = BARH;
+	mon = createmon();
+	mon->mx = mon->wx = mon->my = mon->by = 0;
+	mon->mw = mon->ww = SCREENW;
+	mon->mh = SCREENH;
+	mon->wy = bh;
+	mon->wh = SCREENH - bh;
+	mon->tagset[0] = mon->tagset[1] = 1;
+
+	for(i = 0; i < LENGTH(arranges); i++) {
+		if(!wanted(arranges[i].name))
+			continue;
+		for(j = 0; j < (n ? 1 : LENGTH(counts)); j++) {
+			mon->nvisible = count = n ? n : counts[j];
+			for(hints = 0; hints < HintsLast; hints++) {
+				if(arranges[i].arrange == monocle) {
+					benchlayout(&arranges[i], count, &splits[0], CfactEqual, hints);
+					continue;
+				}
+				for(cfacts = 0; cfacts < CfactLast; cfacts++)
+					for(k = 0; k < LENGTH(splits); k++)
+						benchlayout(&arranges[i], count, &splits[k], cfacts, hints);
+			}
+		}
+	}
+	if(wanted("applysizehints"))
+		for(hints = 0; hints < HintsLast; hints++)
+			benchhints(hints);
+	free(clients);
+	free(infos);
+	free(tiled);
+	free(rects);
+	free(mon);
+	return EXIT_SUCCESS;
+}
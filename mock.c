@@ -0,0 +1,166 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Drives dwm's core against the fake X server of mockx.c. Each scenario
+ * performs its actions one event batch at a time, as dwm's event loop would,
+ * and prints a JSON line with the time, X requests and round trips per
+ * action; -v adds the requests by Xlib call.
+ *
+ * usage: dwm-mock [-v] [clients]
+ */
+#include <time.h>
+
+/* the driver needs dwm's internals, its main() is not used */
+#define main dwmmain
+#include "dwm.c"
+#undef main
+#include "mock.h"
+
+typedef struct {
+	const char *name;
+	unsigned int (*run)(unsigned int n);
+} Scenario;
+
+/* function declarations */
+static unsigned int configurewins(unsigned int n);
+static unsigned int destroywins(unsigned int n);
+static unsigned int focuswins(unsigned int n);
+static unsigned int mapwins(unsigned int n);
+static unsigned int titlewins(unsigned int n);
+static unsigned int urgentwins(unsigned int n);
+static unsigned int viewtags(unsigned int n);
+
+/* variables */
+static Window *wins;
+static unsigned int nwins;
+
+static Scenario scenarios[] = {
+	/* name          function */
+	{ "map",         mapwins },
+	{ "focus",       focuswins },
+	{ "view",        viewtags },
+	{ "title",       titlewins },
+	{ "urgent",      urgentwins },
+	{ "configure",   configurewins },
+	{ "destroy",     destroywins },
+};
+
+/* function implementations */
+unsigned int
+configurewins(unsigned int n) {
+	unsigned int i;
+
+	for(i = 0; i < nwins; i++) {
+		mock_configure(wins[i], i % 100, i % 100, 300 + i % 50, 200 + i % 50);
+		handleevents();
+	}
+	return nwins;
+}
+
+unsigned int
+destroywins(unsigned int n) {
+	unsigned int i;
+
+	for(i = 0; i < nwins; i++) {
+		mock_destroy(wins[i]);
+		handleevents();
+	}
+	return nwins;
+}
+
+unsigned int
+focuswins(unsigned int n) {
+	unsigned int i;
+
+	for(i = 0; i < n; i++) {
+		mock_key(MODKEY, XK_j);
+		handleevents();
+	}
+	return n;
+}
+
+/* every tenth window is fixed size, thus floating */
+unsigned int
+mapwins(unsigned int n) {
+	if(!(wins = calloc(n, sizeof(Window))))
+		die("fatal: could not malloc() %u bytes\n", n * sizeof(Window));
+	for(nwins = 0; nwins < n; nwins++) {
+		wins[nwins] = mock_window("mock", "Mock", 400, 300, nwins % 10 == 9, None);
+		mock_map(wins[nwins]);
+		handleevents();
+	}
+	return n;
+}
+
+unsigned int
+titlewins(unsigned int n) {
+	char buf[32];
+	unsigned int i;
+
+	for(i = 0; i < nwins; i++) {
+		snprintf(buf, sizeof buf, "title %u", i);
+		mock_title(wins[i], buf);
+		handleevents();
+	}
+	return nwins;
+}
+
+unsigned int
+urgentwins(unsigned int n) {
+	unsigned int i;
+
+	for(i = 0; i < 2 * nwins; i++) {
+		mock_urgent(wins[i % nwins], i < nwins);
+		handleevents();
+	}
+	return 2 * nwins;
+}
+
+unsigned int
+viewtags(unsigned int n) {
+	unsigned int i;
+
+	for(i = 0; i < n; i++) {
+		mock_key(MODKEY, XK_1 + i % LENGTH(tags));
+		handleevents();
+	}
+	return n;
+}
+
+int
+main(int argc, char *argv[]) {
+	unsigned int i, n = 1000, actions;
+	Bool verbose = False;
+	struct timespec t0, t1;
+	double us;
+
+	if(argc > 1 && !strcmp(argv[1], "-v")) {
+		verbose = True;
+		argc--, argv++;
+	}
+	if(argc > 2 || (argc == 2 && !(n = atoi(argv[1]))))
+		die("usage: dwm-mock [-v] [clients]\n");
+	if(!(dpy = XOpenDisplay(NULL)))
+		die("dwm-mock: cannot open display\n");
+	checkotherwm();
+	setup();
+	scan();
+	/* monitors start with no tag viewed */
+	mock_key(MODKEY, XK_1);
+	handleevents();
+	for(i = 0; i < LENGTH(scenarios); i++) {
+		mock_reset();
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		actions = scenarios[i].run(n);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		us = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+		printf("{\"scenario\":\"%s\",\"clients\":%u,\"actions\":%u,\"us\":%.3f,"
+		       "\"requests\":%.2f,\"roundtrips\":%.2f}\n", scenarios[i].name, n, actions,
+		       us / actions, (double)mock_requests / actions, (double)mock_roundtrips / actions);
+		if(verbose)
+			mock_dump(stdout);
+	}
+	cleanup();
+	XCloseDisplay(dpy);
+	free(wins);
+	return EXIT_SUCCESS;
+}
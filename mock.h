@@ -0,0 +1,41 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * In-memory stand-in for the X server, implemented in mockx.c by the Xlib
+ * calls dwm makes. Linked instead of libX11 and drw.c it runs dwm's core
+ * without a display: windows, properties, atoms and the event queue live in
+ * memory and every call that would send a request is counted, so a driver
+ * can time an action and know exactly what it would have cost on the wire.
+ *
+ * The server side is deliberately thin. Requests dwm makes change the model
+ * but only generate the events dwm itself depends on (PropertyNotify); the
+ * mock_* calls below act as clients and the user and queue the events the
+ * server would deliver to the window manager.
+ */
+
+typedef struct {
+	const char *name;          /* Xlib call */
+	unsigned long n;
+} MockCount;
+
+extern unsigned long mock_requests, mock_roundtrips;
+extern MockCount mock_counts[];
+extern unsigned int mock_ncounts;
+
+/* clients, queueing the events dwm would receive */
+Window mock_window(const char *instance, const char *class, int w, int h, Bool fixed, Window transient);
+void mock_map(Window w);
+void mock_unmap(Window w);
+void mock_destroy(Window w);
+void mock_configure(Window w, int x, int y, int width, int height);
+void mock_title(Window w, const char *title);
+void mock_urgent(Window w, Bool urgent);
+
+/* user input */
+void mock_key(unsigned int mod, KeySym keysym);
+void mock_button(Window w, unsigned int mod, unsigned int button, int x, int y);
+void mock_motion(int x, int y);
+void mock_release(unsigned int button);
+
+/* request accounting */
+void mock_dump(FILE *f);
+void mock_reset(void);
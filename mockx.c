@@ -0,0 +1,1365 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Fake Xlib and drw for dwm-mock, see mock.h. Only what dwm.c calls is
+ * implemented, with the semantics dwm relies on.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <X11/Xatom.h>
+#include <X11/XKBlib.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/sync.h>
+
+#include "drw.h"
+#include "mock.h"
+#include "util.h"
+
+#define LENGTH(X)               (sizeof X / sizeof X[0])
+#define ROOTWIN                 0x100
+#define MAXCOUNTS               128
+#define REQUEST()               request(__func__, False)
+#define ROUNDTRIP()             request(__func__, True)
+
+typedef struct Prop Prop;
+struct Prop {
+	Atom atom, type;
+	int format;
+	unsigned long n;           /* items, 32 bit ones stored as long */
+	unsigned char *data;
+	Prop *next;
+};
+
+typedef struct {
+	Bool live, mapped, override;
+	Window parent;
+	int x, y, w, h, bw;
+	long mask;
+	Prop *props;
+} Win;
+
+/* function declarations */
+static void delprop(Window w, Atom atom);
+static void *ecalloc(size_t nmemb, size_t size);
+static char *estrndup(const char *s, size_t n);
+static void enqueue(XEvent *ev);
+static unsigned long evmask(int type);
+static Bool evnext(XEvent *ev, Bool (*match)(XEvent *, XPointer), XPointer arg);
+static Atom findatom(const char *name);
+static Prop *getprop(Window w, Atom atom);
+static Window newwin(Window parent, int x, int y, int w, int h, int bw);
+static void propertynotify(Window w, Atom atom, int state);
+static void request(const char *name, Bool roundtrip);
+static int readprop(Window w, Atom atom, long offset, long length, Atom reqtype, Atom *type,
+                    int *format, unsigned long *n, unsigned long *after, unsigned char **data);
+static void setprop(Window w, Atom atom, Atom type, int format, const void *data, unsigned long n, int mode);
+static Win *win(Window w);
+
+/* variables */
+unsigned long mock_requests, mock_roundtrips;
+MockCount mock_counts[MAXCOUNTS];
+unsigned int mock_ncounts;
+
+static Display *dpy;
+static Screen scr;
+static Visual visual;
+static char dpyname[32];
+static Win *wins;
+static unsigned long nwins;
+static XEvent *queue;
+static unsigned long qhead, qlen, qsize;
+static char **atomnames;
+static unsigned long natoms;
+static KeySym keysyms[256];
+static int ptrx, ptry;
+static XErrorHandler errorhandler;
+
+/* model */
+void
+delprop(Window w, Atom atom) {
+	Win *wp = win(w);
+	Prop **pp, *p;
+
+	for(pp = wp ? &wp->props : NULL; pp && *pp && (*pp)->atom != atom; pp = &(*pp)->next);
+	if(!pp || !(p = *pp))
+		return;
+	*pp = p->next;
+	free(p->data);
+	free(p);
+	propertynotify(w, atom, PropertyDelete);
+}
+
+void *
+ecalloc(size_t nmemb, size_t size) {
+	void *p;
+
+	if(!(p = calloc(nmemb, size)))
+		die("fatal: could not malloc() %u bytes\n", nmemb * size);
+	return p;
+}
+
+char *
+estrndup(const char *s, size_t n) {
+	char *d = ecalloc(n + 1, 1);
+	size_t i;
+
+	for(i = 0; i < n && s[i]; i++)
+		d[i] = s[i];
+	return d;
+}
+
+void
+enqueue(XEvent *ev) {
+	if(qhead + qlen == qsize) {
+		if(qhead > qsize / 2) {
+			memmove(queue, queue + qhead, qlen * sizeof(XEvent));
+			qhead = 0;
+		}
+		else if(!(queue = realloc(queue, (qsize = qsize * 2 + 64) * sizeof(XEvent))))
+			die("fatal: could not realloc() %u bytes\n", qsize * sizeof(XEvent));
+	}
+	ev->xany.serial = NextRequest(dpy) - 1;
+	ev->xany.display = dpy;
+	queue[qhead + qlen++] = *ev;
+}
+
+/* the input mask an event type is selected by */
+unsigned long
+evmask(int type) {
+	switch(type) {
+	case KeyPress:         return KeyPressMask;
+	case ButtonPress:      return ButtonPressMask;
+	case ButtonRelease:    return ButtonReleaseMask;
+	case MotionNotify:     return PointerMotionMask|ButtonMotionMask;
+	case EnterNotify:      return EnterWindowMask;
+	case Expose:           return ExposureMask;
+	case PropertyNotify:   return PropertyChangeMask;
+	case MapRequest:
+	case ConfigureRequest: return SubstructureRedirectMask;
+	case ConfigureNotify:
+	case DestroyNotify:
+	case UnmapNotify:      return StructureNotifyMask|SubstructureNotifyMask;
+	}
+	return 0;
+}
+
+/* takes the first queued event matching, a real server would block instead
+ * of there being none */
+Bool
+evnext(XEvent *ev, Bool (*match)(XEvent *, XPointer), XPointer arg) {
+	unsigned long i;
+
+	for(i = qhead; i < qhead + qlen; i++)
+		if(!match || match(&queue[i], arg)) {
+			*ev = queue[i];
+			memmove(&queue[i], &queue[i + 1], (qhead + --qlen - i) * sizeof(XEvent));
+			return True;
+		}
+	return False;
+}
+
+/* atoms interned so far, without a round trip as Xlib caches them */
+Atom
+findatom(const char *name) {
+	unsigned long i;
+
+	for(i = 0; i < natoms; i++)
+		if(!strcmp(atomnames[i], name))
+			return XA_LAST_PREDEFINED + 1 + i;
+	return None;
+}
+
+Prop *
+getprop(Window w, Atom atom) {
+	Win *wp = win(w);
+	Prop *p;
+
+	for(p = wp ? wp->props : NULL; p && p->atom != atom; p = p->next);
+	return p;
+}
+
+Window
+newwin(Window parent, int x, int y, int w, int h, int bw) {
+	Win *wp;
+
+	if(!(nwins % 1024) && !(wins = realloc(wins, (nwins + 1024) * sizeof(Win))))
+		die("fatal: could not realloc() %u bytes\n", (nwins + 1024) * sizeof(Win));
+	wp = &wins[nwins];
+	memset(wp, 0, sizeof *wp);
+	wp->live = True;
+	wp->parent = parent;
+	wp->x = x;
+	wp->y = y;
+	wp->w = w;
+	wp->h = h;
+	wp->bw = bw;
+	return ROOTWIN + nwins++;
+}
+
+void
+propertynotify(Window w, Atom atom, int state) {
+	Win *wp = win(w);
+	XEvent ev;
+
+	if(!wp || !(wp->mask & PropertyChangeMask))
+		return;
+	memset(&ev, 0, sizeof ev);
+	ev.xproperty.type = PropertyNotify;
+	ev.xproperty.window = w;
+	ev.xproperty.atom = atom;
+	ev.xproperty.state = state;
+	enqueue(&ev);
+}
+
+/* XGetWindowProperty() without the accounting */
+int
+readprop(Window w, Atom atom, long offset, long length, Atom reqtype, Atom *type,
+         int *format, unsigned long *n, unsigned long *after, unsigned char **data) {
+	Prop *p;
+	size_t size, start, end;
+
+	*type = None;
+	*format = 0;
+	*n = *after = 0;
+	*data = NULL;
+	if(!win(w))
+		return BadWindow;
+	if(!(p = getprop(w, atom)))
+		return Success;
+	*type = p->type;
+	*format = p->format;
+	size = p->format == 32 ? sizeof(long) : p->format / 8;
+	if(reqtype != AnyPropertyType && reqtype != p->type) {
+		*after = p->n * (p->format / 8);
+		return Success;
+	}
+	/* offset and length count 32 bit units */
+	start = MIN(offset * 4 / (p->format / 8), p->n);
+	end = MIN(start + length * 4 / (p->format / 8), p->n);
+	*n = end - start;
+	*after = (p->n - end) * (p->format / 8);
+	*data = ecalloc(*n + 1, size);
+	memcpy(*data, p->data + start * size, *n * size);
+	return Success;
+}
+
+void
+request(const char *name, Bool roundtrip) {
+	unsigned int i;
+
+	((_XPrivDisplay)dpy)->request++;
+	mock_requests++;
+	if(roundtrip)
+		mock_roundtrips++;
+	for(i = 0; i < mock_ncounts && mock_counts[i].name != name
+	    && strcmp(mock_counts[i].name, name); i++);
+	if(i == mock_ncounts && mock_ncounts < MAXCOUNTS)
+		mock_counts[mock_ncounts++].name = name;
+	if(i < mock_ncounts)
+		mock_counts[i].n++;
+}
+
+void
+setprop(Window w, Atom atom, Atom type, int format, const void *data, unsigned long n, int mode) {
+	Win *wp = win(w);
+	Prop *p;
+	size_t size = format == 32 ? sizeof(long) : format / 8;
+	unsigned char *d;
+
+	if(!wp)
+		return;
+	if(!(p = getprop(w, atom))) {
+		p = ecalloc(1, sizeof(Prop));
+		p->atom = atom;
+		p->next = wp->props;
+		wp->props = p;
+	}
+	if(mode == PropModeReplace || p->format != format || p->type != type)
+		p->n = 0;
+	d = ecalloc(p->n + n + 1, size); /* NUL terminated for strings */
+	if(mode == PropModePrepend) {
+		memcpy(d, data, n * size);
+		if(p->n)
+			memcpy(d + n * size, p->data, p->n * size);
+	}
+	else {
+		if(p->n)
+			memcpy(d, p->data, p->n * size);
+		memcpy(d + p->n * size, data, n * size);
+	}
+	free(p->data);
+	p->data = d;
+	p->n += n;
+	p->type = type;
+	p->format = format;
+}
+
+Win *
+win(Window w) {
+	w -= ROOTWIN;
+	return w < nwins && wins[w].live ? &wins[w] : NULL;
+}
+
+/* clients */
+Window
+mock_window(const char *instance, const char *class, int w, int h, Bool fixed, Window transient) {
+	long hints[18] = { 0 }, wmhints[9] = { InputHint, True };
+	char buf[256];
+	Window id = newwin(ROOTWIN, 0, 0, w, h, 0);
+	int n;
+
+	n = snprintf(buf, sizeof buf - 1, "%s%c%s", instance, '\0', class) + 1;
+	setprop(id, XA_WM_CLASS, XA_STRING, 8, buf, MIN(n, (int)sizeof buf), PropModeReplace);
+	setprop(id, XA_WM_NAME, XA_STRING, 8, instance, strlen(instance), PropModeReplace);
+	setprop(id, XA_WM_HINTS, XA_WM_HINTS, 32, wmhints, LENGTH(wmhints), PropModeReplace);
+	if(fixed) {
+		hints[0] = PMinSize | PMaxSize;
+		hints[5] = hints[7] = w;
+		hints[6] = hints[8] = h;
+		setprop(id, XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS, 32, hints, LENGTH(hints), PropModeReplace);
+	}
+	if(transient)
+		setprop(id, XA_WM_TRANSIENT_FOR, XA_WINDOW, 32, &transient, 1, PropModeReplace);
+	return id;
+}
+
+void
+mock_map(Window w) {
+	XEvent ev;
+
+	memset(&ev, 0, sizeof ev);
+	ev.xmaprequest.type = MapRequest;
+	ev.xmaprequest.parent = ROOTWIN;
+	ev.xmaprequest.window = w;
+	enqueue(&ev);
+}
+
+void
+mock_unmap(Window w) {
+	XEvent ev;
+
+	win(w)->mapped = False;
+	memset(&ev, 0, sizeof ev);
+	ev.xunmap.type = UnmapNotify;
+	ev.xunmap.event = w;
+	ev.xunmap.window = w;
+	if(win(w)->mask & StructureNotifyMask)
+		enqueue(&ev);
+	ev.xunmap.event = ROOTWIN;
+	enqueue(&ev);
+}
+
+void
+mock_destroy(Window w) {
+	XEvent ev;
+	Win *wp = win(w);
+	Prop *p;
+
+	if(!wp)
+		return;
+	if(wp->mapped)
+		mock_unmap(w);
+	memset(&ev, 0, sizeof ev);
+	ev.xdestroywindow.type = DestroyNotify;
+	ev.xdestroywindow.event = w;
+	ev.xdestroywindow.window = w;
+	if(wp->mask & StructureNotifyMask)
+		enqueue(&ev);
+	ev.xdestroywindow.event = ROOTWIN;
+	enqueue(&ev);
+	while((p = wp->props)) {
+		wp->props = p->next;
+		free(p->data);
+		free(p);
+	}
+	wp->live = False;
+}
+
+void
+mock_configure(Window w, int x, int y, int width, int height) {
+	XEvent ev;
+
+	memset(&ev, 0, sizeof ev);
+	ev.xconfigurerequest.type = ConfigureRequest;
+	ev.xconfigurerequest.parent = ROOTWIN;
+	ev.xconfigurerequest.window = w;
+	ev.xconfigurerequest.x = x;
+	ev.xconfigurerequest.y = y;
+	ev.xconfigurerequest.width = width;
+	ev.xconfigurerequest.height = height;
+	ev.xconfigurerequest.value_mask = CWX|CWY|CWWidth|CWHeight;
+	enqueue(&ev);
+}
+
+void
+mock_title(Window w, const char *title) {
+	setprop(w, XA_WM_NAME, XA_STRING, 8, title, strlen(title), PropModeReplace);
+	propertynotify(w, XA_WM_NAME, PropertyNewValue);
+}
+
+void
+mock_urgent(Window w, Bool urgent) {
+	long wmhints[9] = { InputHint, True };
+
+	if(urgent)
+		wmhints[0] |= XUrgencyHint;
+	setprop(w, XA_WM_HINTS, XA_WM_HINTS, 32, wmhints, LENGTH(wmhints), PropModeReplace);
+	propertynotify(w, XA_WM_HINTS, PropertyNewValue);
+}
+
+/* user input */
+void
+mock_key(unsigned int mod, KeySym keysym) {
+	XEvent ev;
+
+	memset(&ev, 0, sizeof ev);
+	ev.xkey.type = KeyPress;
+	ev.xkey.window = ev.xkey.root = ROOTWIN;
+	ev.xkey.state = mod;
+	ev.xkey.keycode = XKeysymToKeycode(dpy, keysym);
+	ev.xkey.x_root = ptrx;
+	ev.xkey.y_root = ptry;
+	enqueue(&ev);
+}
+
+void
+mock_button(Window w, unsigned int mod, unsigned int button, int x, int y) {
+	XEvent ev;
+
+	ptrx = x;
+	ptry = y;
+	memset(&ev, 0, sizeof ev);
+	ev.xbutton.type = ButtonPress;
+	ev.xbutton.window = w;
+	ev.xbutton.root = ROOTWIN;
+	ev.xbutton.state = mod;
+	ev.xbutton.button = button;
+	ev.xbutton.x = ev.xbutton.x_root = x;
+	ev.xbutton.y = ev.xbutton.y_root = y;
+	enqueue(&ev);
+}
+
+void
+mock_motion(int x, int y) {
+	static Time t;
+	XEvent ev;
+
+	ptrx = x;
+	ptry = y;
+	memset(&ev, 0, sizeof ev);
+	ev.xmotion.type = MotionNotify;
+	ev.xmotion.window = ev.xmotion.root = ROOTWIN;
+	ev.xmotion.x = ev.xmotion.x_root = x;
+	ev.xmotion.y = ev.xmotion.y_root = y;
+	ev.xmotion.time = t += 20; /* 50 Hz, see refreshrate */
+	enqueue(&ev);
+}
+
+void
+mock_release(unsigned int button) {
+	XEvent ev;
+
+	memset(&ev, 0, sizeof ev);
+	ev.xbutton.type = ButtonRelease;
+	ev.xbutton.window = ev.xbutton.root = ROOTWIN;
+	ev.xbutton.button = button;
+	ev.xbutton.x = ev.xbutton.x_root = ptrx;
+	ev.xbutton.y = ev.xbutton.y_root = ptry;
+	enqueue(&ev);
+}
+
+/* request accounting */
+void
+mock_dump(FILE *f) {
+	unsigned int i;
+
+	for(i = 0; i < mock_ncounts; i++)
+		if(mock_counts[i].n)
+			fprintf(f, "%-28s %10lu\n", mock_counts[i].name, mock_counts[i].n);
+}
+
+void
+mock_reset(void) {
+	unsigned int i;
+
+	mock_requests = mock_roundtrips = 0;
+	for(i = 0; i < mock_ncounts; i++)
+		mock_counts[i].n = 0;
+}
+
+/* Xlib: display */
+Display *
+XOpenDisplay(_Xconst char *name) {
+	_XPrivDisplay d;
+
+	if(dpy)
+		return NULL;
+	d = ecalloc(1, sizeof *d);
+	/* a display number of its own keeps dwm's sockets and files apart */
+	snprintf(dpyname, sizeof dpyname, ":%d", (int)getpid());
+	d->display_name = dpyname;
+	d->fd = -1;
+	d->nscreens = 1;
+	d->screens = &scr;
+	scr.display = (Display *)d;
+	scr.root = newwin(None, 0, 0, 1920, 1080, 0);
+	scr.width = 1920;
+	scr.height = 1080;
+	scr.root_depth = 24;
+	scr.root_visual = &visual;
+	scr.cmap = 0x20;
+	return dpy = (Display *)d;
+}
+
+int
+XCloseDisplay(Display *d) {
+	free(d);
+	dpy = NULL;
+	return 0;
+}
+
+XErrorHandler
+XSetErrorHandler(XErrorHandler handler) {
+	XErrorHandler old = errorhandler;
+
+	errorhandler = handler;
+	return old;
+}
+
+Bool
+XSupportsLocale(void) {
+	return True;
+}
+
+int
+XFree(void *data) {
+	free(data);
+	return 1;
+}
+
+int
+XSync(Display *d, Bool discard) {
+	ROUNDTRIP();
+	if(discard)
+		qlen = 0;
+	return 1;
+}
+
+int
+XSetCloseDownMode(Display *d, int mode) {
+	REQUEST();
+	return 1;
+}
+
+int
+XGrabServer(Display *d) {
+	REQUEST();
+	return 1;
+}
+
+int
+XUngrabServer(Display *d) {
+	REQUEST();
+	return 1;
+}
+
+int
+XKillClient(Display *d, XID resource) {
+	REQUEST();
+	mock_destroy(resource);
+	return 1;
+}
+
+/* Xlib: windows */
+Window
+XCreateWindow(Display *d, Window parent, int x, int y, unsigned int w, unsigned int h,
+              unsigned int bw, int depth, unsigned int class, Visual *vis,
+              unsigned long mask, XSetWindowAttributes *wa) {
+	Window id;
+
+	REQUEST();
+	id = newwin(parent, x, y, w, h, bw);
+	if(mask & CWOverrideRedirect)
+		win(id)->override = wa->override_redirect;
+	if(mask & CWEventMask)
+		win(id)->mask = wa->event_mask;
+	return id;
+}
+
+Window
+XCreateSimpleWindow(Display *d, Window parent, int x, int y, unsigned int w, unsigned int h,
+                    unsigned int bw, unsigned long border, unsigned long background) {
+	REQUEST();
+	return newwin(parent, x, y, w, h, bw);
+}
+
+int
+XDestroyWindow(Display *d, Window w) {
+	Win *wp;
+	Prop *p;
+
+	REQUEST();
+	if(!(wp = win(w)))
+		return 1;
+	while((p = wp->props)) {
+		wp->props = p->next;
+		free(p->data);
+		free(p);
+	}
+	wp->live = False;
+	return 1;
+}
+
+int
+XMapWindow(Display *d, Window w) {
+	REQUEST();
+	if(win(w))
+		win(w)->mapped = True;
+	return 1;
+}
+
+int
+XMapRaised(Display *d, Window w) {
+	REQUEST();
+	if(win(w))
+		win(w)->mapped = True;
+	return 1;
+}
+
+int
+XUnmapWindow(Display *d, Window w) {
+	REQUEST();
+	if(win(w))
+		win(w)->mapped = False;
+	return 1;
+}
+
+int
+XConfigureWindow(Display *d, Window w, unsigned int mask, XWindowChanges *wc) {
+	Win *wp;
+
+	REQUEST();
+	if(!(wp = win(w)))
+		return 1;
+	if(mask & CWX)
+		wp->x = wc->x;
+	if(mask & CWY)
+		wp->y = wc->y;
+	if(mask & CWWidth)
+		wp->w = wc->width;
+	if(mask & CWHeight)
+		wp->h = wc->height;
+	if(mask & CWBorderWidth)
+		wp->bw = wc->border_width;
+	return 1;
+}
+
+int
+XMoveWindow(Display *d, Window w, int x, int y) {
+	REQUEST();
+	if(win(w)) {
+		win(w)->x = x;
+		win(w)->y = y;
+	}
+	return 1;
+}
+
+int
+XMoveResizeWindow(Display *d, Window w, int x, int y, unsigned int width, unsigned int height) {
+	REQUEST();
+	if(win(w)) {
+		win(w)->x = x;
+		win(w)->y = y;
+		win(w)->w = width;
+		win(w)->h = height;
+	}
+	return 1;
+}
+
+int
+XRaiseWindow(Display *d, Window w) {
+	REQUEST();
+	return 1;
+}
+
+/* Xlib sends a ConfigureWindow for each window but the first */
+int
+XRestackWindows(Display *d, Window *ws, int n) {
+	while(--n > 0)
+		REQUEST();
+	return 1;
+}
+
+int
+XSetWindowBorder(Display *d, Window w, unsigned long pixel) {
+	REQUEST();
+	return 1;
+}
+
+int
+XDefineCursor(Display *d, Window w, Cursor cursor) {
+	REQUEST();
+	return 1;
+}
+
+int
+XChangeWindowAttributes(Display *d, Window w, unsigned long mask, XSetWindowAttributes *wa) {
+	REQUEST();
+	if(win(w) && mask & CWEventMask)
+		win(w)->mask = wa->event_mask;
+	return 1;
+}
+
+int
+XSelectInput(Display *d, Window w, long mask) {
+	REQUEST();
+	if(win(w))
+		win(w)->mask = mask;
+	return 1;
+}
+
+int
+XSetInputFocus(Display *d, Window focus, int revert, Time t) {
+	REQUEST();
+	return 1;
+}
+
+Status
+XGetWindowAttributes(Display *d, Window w, XWindowAttributes *wa) {
+	Win *wp;
+
+	ROUNDTRIP();
+	if(!(wp = win(w)))
+		return 0;
+	memset(wa, 0, sizeof *wa);
+	wa->x = wp->x;
+	wa->y = wp->y;
+	wa->width = wp->w;
+	wa->height = wp->h;
+	wa->border_width = wp->bw;
+	wa->depth = scr.root_depth;
+	wa->visual = &visual;
+	wa->root = ROOTWIN;
+	wa->screen = &scr;
+	wa->map_state = wp->mapped ? IsViewable : IsUnmapped;
+	wa->override_redirect = wp->override;
+	wa->your_event_mask = wp->mask;
+	return 1;
+}
+
+Status
+XQueryTree(Display *d, Window w, Window *root, Window *parent, Window **children, unsigned int *n) {
+	unsigned long i;
+
+	ROUNDTRIP();
+	*root = ROOTWIN;
+	*parent = win(w) ? win(w)->parent : None;
+	*children = ecalloc(nwins + 1, sizeof(Window));
+	for(*n = 0, i = 0; i < nwins; i++)
+		if(wins[i].live && wins[i].parent == w)
+			(*children)[(*n)++] = ROOTWIN + i;
+	return 1;
+}
+
+/* Xlib: properties and atoms */
+Atom
+XInternAtom(Display *d, _Xconst char *name, Bool onlyifexists) {
+	Atom a;
+
+	ROUNDTRIP();
+	if((a = findatom(name)) || onlyifexists)
+		return a;
+	if(!(natoms % 64) && !(atomnames = realloc(atomnames, (natoms + 64) * sizeof(char *))))
+		die("fatal: could not realloc() %u bytes\n", (natoms + 64) * sizeof(char *));
+	atomnames[natoms] = estrndup(name, strlen(name));
+	return XA_LAST_PREDEFINED + 1 + natoms++;
+}
+
+char *
+XGetAtomName(Display *d, Atom atom) {
+	char buf[32], *name = buf;
+
+	ROUNDTRIP();
+	if(atom > XA_LAST_PREDEFINED && atom - XA_LAST_PREDEFINED - 1 < natoms)
+		name = atomnames[atom - XA_LAST_PREDEFINED - 1];
+	else
+		snprintf(buf, sizeof buf, "ATOM_%lu", atom);
+	return estrndup(name, strlen(name));
+}
+
+int
+XChangeProperty(Display *d, Window w, Atom atom, Atom type, int format, int mode,
+                _Xconst unsigned char *data, int n) {
+	REQUEST();
+	if(!win(w))
+		return 1;
+	setprop(w, atom, type, format, data, n, mode);
+	propertynotify(w, atom, PropertyNewValue);
+	return 1;
+}
+
+int
+XDeleteProperty(Display *d, Window w, Atom atom) {
+	REQUEST();
+	delprop(w, atom);
+	return 1;
+}
+
+int
+XGetWindowProperty(Display *d, Window w, Atom atom, long offset, long length, Bool delete,
+                   Atom reqtype, Atom *type, int *format, unsigned long *n,
+                   unsigned long *after, unsigned char **data) {
+	int r;
+
+	ROUNDTRIP();
+	r = readprop(w, atom, offset, length, reqtype, type, format, n, after, data);
+	if(delete && *data && !*after)
+		delprop(w, atom);
+	return r;
+}
+
+Atom *
+XListProperties(Display *d, Window w, int *n) {
+	Atom *atoms;
+	Prop *p;
+
+	ROUNDTRIP();
+	for(*n = 0, p = win(w) ? win(w)->props : NULL; p; p = p->next, (*n)++);
+	if(!*n)
+		return NULL;
+	atoms = ecalloc(*n, sizeof(Atom));
+	for(*n = 0, p = win(w)->props; p; p = p->next)
+		atoms[(*n)++] = p->atom;
+	return atoms;
+}
+
+Status
+XGetTextProperty(Display *d, Window w, XTextProperty *tp, Atom atom) {
+	unsigned long after;
+
+	ROUNDTRIP();
+	memset(tp, 0, sizeof *tp);
+	return readprop(w, atom, 0L, 1024L, AnyPropertyType, &tp->encoding, &tp->format,
+	                &tp->nitems, &after, &tp->value) == Success && tp->value;
+}
+
+int
+XmbTextPropertyToTextList(Display *d, const XTextProperty *tp, char ***list, int *n) {
+	*list = ecalloc(2, sizeof(char *));
+	(*list)[0] = estrndup((char *)tp->value, tp->nitems);
+	*n = 1;
+	return Success;
+}
+
+void
+XFreeStringList(char **list) {
+	char **s;
+
+	for(s = list; s && *s; s++)
+		free(*s);
+	free(list);
+}
+
+Status
+XGetClassHint(Display *d, Window w, XClassHint *ch) {
+	unsigned char *p;
+	unsigned long n, after, len;
+	int format;
+	Atom type;
+
+	ROUNDTRIP();
+	ch->res_name = ch->res_class = NULL;
+	if(readprop(w, XA_WM_CLASS, 0L, 1024L, XA_STRING, &type, &format, &n, &after, &p) != Success || !p)
+		return 0;
+	ch->res_name = estrndup((char *)p, n);
+	len = strlen(ch->res_name);
+	ch->res_class = estrndup(len < n ? (char *)p + len + 1 : "", len < n ? n - len - 1 : 0);
+	free(p);
+	return 1;
+}
+
+Status
+XGetTransientForHint(Display *d, Window w, Window *transient) {
+	Prop *p;
+
+	ROUNDTRIP();
+	*transient = None;
+	if(!(p = getprop(w, XA_WM_TRANSIENT_FOR)) || p->type != XA_WINDOW || !p->n)
+		return 0;
+	*transient = *(long *)p->data;
+	return 1;
+}
+
+Status
+XGetWMProtocols(Display *d, Window w, Atom **protocols, int *n) {
+	Prop *p;
+
+	ROUNDTRIP();
+	*protocols = NULL;
+	*n = 0;
+	if(!(p = getprop(w, findatom("WM_PROTOCOLS"))) || p->type != XA_ATOM || !p->n)
+		return 0;
+	*protocols = ecalloc(p->n, sizeof(Atom));
+	memcpy(*protocols, p->data, p->n * sizeof(Atom));
+	*n = p->n;
+	return 1;
+}
+
+Status
+XGetWMNormalHints(Display *d, Window w, XSizeHints *h, long *supplied) {
+	Prop *p;
+	long *v;
+
+	ROUNDTRIP();
+	memset(h, 0, sizeof *h);
+	*supplied = 0;
+	if(!(p = getprop(w, XA_WM_NORMAL_HINTS)) || p->format != 32 || p->n < 18)
+		return 0;
+	v = (long *)p->data;
+	h->flags = v[0];
+	h->x = v[1];
+	h->y = v[2];
+	h->width = v[3];
+	h->height = v[4];
+	h->min_width = v[5];
+	h->min_height = v[6];
+	h->max_width = v[7];
+	h->max_height = v[8];
+	h->width_inc = v[9];
+	h->height_inc = v[10];
+	h->min_aspect.x = v[11];
+	h->min_aspect.y = v[12];
+	h->max_aspect.x = v[13];
+	h->max_aspect.y = v[14];
+	h->base_width = v[15];
+	h->base_height = v[16];
+	h->win_gravity = v[17];
+	*supplied = USPosition|USSize|PAllHints|PBaseSize|PWinGravity;
+	return 1;
+}
+
+XWMHints *
+XGetWMHints(Display *d, Window w) {
+	XWMHints *h;
+	Prop *p;
+	long *v;
+
+	ROUNDTRIP();
+	if(!(p = getprop(w, XA_WM_HINTS)) || p->format != 32 || p->n < 9)
+		return NULL;
+	v = (long *)p->data;
+	h = ecalloc(1, sizeof(XWMHints));
+	h->flags = v[0];
+	h->input = v[1];
+	h->initial_state = v[2];
+	h->icon_pixmap = v[3];
+	h->icon_window = v[4];
+	h->icon_x = v[5];
+	h->icon_y = v[6];
+	h->icon_mask = v[7];
+	h->window_group = v[8];
+	return h;
+}
+
+int
+XSetWMHints(Display *d, Window w, XWMHints *h) {
+	long v[9];
+
+	v[0] = h->flags;
+	v[1] = h->input;
+	v[2] = h->initial_state;
+	v[3] = h->icon_pixmap;
+	v[4] = h->icon_window;
+	v[5] = h->icon_x;
+	v[6] = h->icon_y;
+	v[7] = h->icon_mask;
+	v[8] = h->window_group;
+	REQUEST();
+	setprop(w, XA_WM_HINTS, XA_WM_HINTS, 32, v, LENGTH(v), PropModeReplace);
+	propertynotify(w, XA_WM_HINTS, PropertyNewValue);
+	return 1;
+}
+
+/* Xlib: events */
+int
+XPending(Display *d) {
+	return qlen;
+}
+
+int
+XNextEvent(Display *d, XEvent *ev) {
+	if(!evnext(ev, NULL, NULL))
+		die("mock: XNextEvent would block\n");
+	return 0;
+}
+
+int
+XPeekEvent(Display *d, XEvent *ev) {
+	if(!qlen)
+		die("mock: XPeekEvent would block\n");
+	*ev = queue[qhead];
+	return 1;
+}
+
+static Bool
+matchmask(XEvent *ev, XPointer mask) {
+	return (evmask(ev->type) & *(long *)mask) != 0;
+}
+
+int
+XMaskEvent(Display *d, long mask, XEvent *ev) {
+	if(!evnext(ev, matchmask, (XPointer)&mask))
+		die("mock: XMaskEvent would block\n");
+	return 0;
+}
+
+Bool
+XCheckMaskEvent(Display *d, long mask, XEvent *ev) {
+	return evnext(ev, matchmask, (XPointer)&mask);
+}
+
+typedef struct {
+	Display *dpy;
+	Bool (*predicate)(Display *, XEvent *, XPointer);
+	XPointer arg;
+} Predicate;
+
+static Bool
+matchpredicate(XEvent *ev, XPointer p) {
+	return ((Predicate *)p)->predicate(((Predicate *)p)->dpy, ev, ((Predicate *)p)->arg);
+}
+
+int
+XIfEvent(Display *d, XEvent *ev, Bool (*predicate)(Display *, XEvent *, XPointer), XPointer arg) {
+	Predicate p = { d, predicate, arg };
+
+	if(!evnext(ev, matchpredicate, (XPointer)&p))
+		die("mock: XIfEvent would block\n");
+	return 0;
+}
+
+Bool
+XCheckIfEvent(Display *d, XEvent *ev, Bool (*predicate)(Display *, XEvent *, XPointer), XPointer arg) {
+	Predicate p = { d, predicate, arg };
+
+	return evnext(ev, matchpredicate, (XPointer)&p);
+}
+
+static Bool
+matchtyped(XEvent *ev, XPointer want) {
+	return ev->type == ((XEvent *)want)->type && ev->xany.window == ((XEvent *)want)->xany.window;
+}
+
+Bool
+XCheckTypedWindowEvent(Display *d, Window w, int type, XEvent *ev) {
+	XEvent want;
+
+	want.type = type;
+	want.xany.window = w;
+	return evnext(ev, matchtyped, (XPointer)&want);
+}
+
+Status
+XSendEvent(Display *d, Window w, Bool propagate, long mask, XEvent *ev) {
+	REQUEST(); /* mock clients ignore what dwm sends them */
+	return 1;
+}
+
+/* Xlib: input */
+int
+XGrabKey(Display *d, int keycode, unsigned int mod, Window w, Bool owner, int pmode, int kmode) {
+	REQUEST();
+	return 1;
+}
+
+int
+XUngrabKey(Display *d, int keycode, unsigned int mod, Window w) {
+	REQUEST();
+	return 1;
+}
+
+int
+XGrabButton(Display *d, unsigned int button, unsigned int mod, Window w, Bool owner,
+            unsigned int mask, int pmode, int kmode, Window confine, Cursor cursor) {
+	REQUEST();
+	return 1;
+}
+
+int
+XUngrabButton(Display *d, unsigned int button, unsigned int mod, Window w) {
+	REQUEST();
+	return 1;
+}
+
+int
+XGrabPointer(Display *d, Window w, Bool owner, unsigned int mask, int pmode, int kmode,
+             Window confine, Cursor cursor, Time t) {
+	ROUNDTRIP();
+	return GrabSuccess;
+}
+
+int
+XUngrabPointer(Display *d, Time t) {
+	REQUEST();
+	return 1;
+}
+
+Bool
+XQueryPointer(Display *d, Window w, Window *root, Window *child, int *rx, int *ry,
+              int *wx, int *wy, unsigned int *mask) {
+	ROUNDTRIP();
+	*root = ROOTWIN;
+	*child = None;
+	*rx = *wx = ptrx;
+	*ry = *wy = ptry;
+	*mask = 0;
+	return True;
+}
+
+int
+XWarpPointer(Display *d, Window src, Window dst, int sx, int sy, unsigned int sw,
+             unsigned int sh, int dx, int dy) {
+	REQUEST();
+	if(win(dst)) {
+		ptrx = win(dst)->x + dx;
+		ptry = win(dst)->y + dy;
+	}
+	return 1;
+}
+
+/* keycodes are handed out as keysyms are asked for */
+KeyCode
+XKeysymToKeycode(Display *d, KeySym keysym) {
+	unsigned int i;
+
+	for(i = 8; i < LENGTH(keysyms) && keysyms[i] && keysyms[i] != keysym; i++);
+	if(i == LENGTH(keysyms))
+		return 0;
+	keysyms[i] = keysym;
+	return i;
+}
+
+KeySym
+XkbKeycodeToKeysym(Display *d,
+#if NeedWidePrototypes
+                   unsigned int keycode,
+#else
+                   KeyCode keycode,
+#endif
+                   int group, int level) {
+	return keysyms[keycode];
+}
+
+char *
+XKeysymToString(KeySym keysym) {
+	static char buf[32];
+
+	snprintf(buf, sizeof buf, "0x%lx", keysym);
+	return buf;
+}
+
+int
+XRefreshKeyboardMapping(XMappingEvent *ev) {
+	return 0;
+}
+
+XModifierKeymap *
+XGetModifierMapping(Display *d) {
+	XModifierKeymap *map = ecalloc(1, sizeof(XModifierKeymap));
+
+	ROUNDTRIP();
+	map->max_keypermod = 1;
+	map->modifiermap = ecalloc(8, sizeof(KeyCode)); /* no NumLock */
+	return map;
+}
+
+int
+XFreeModifiermap(XModifierKeymap *map) {
+	free(map->modifiermap);
+	free(map);
+	return 1;
+}
+
+/* SYNC extension, not present */
+Status
+XSyncQueryExtension(Display *d, int *evbase, int *errbase) {
+	return False;
+}
+
+Status
+XSyncInitialize(Display *d, int *major, int *minor) {
+	return False;
+}
+
+Status
+XSyncQueryCounter(Display *d, XSyncCounter counter, XSyncValue *value) {
+	return False;
+}
+
+XSyncAlarm
+XSyncCreateAlarm(Display *d, unsigned long mask, XSyncAlarmAttributes *aa) {
+	return None;
+}
+
+Status
+XSyncChangeAlarm(Display *d, XSyncAlarm alarm, unsigned long mask, XSyncAlarmAttributes *aa) {
+	return False;
+}
+
+Status
+XSyncDestroyAlarm(Display *d, XSyncAlarm alarm) {
+	return False;
+}
+
+void
+XSyncIntToValue(XSyncValue *v, int i) {
+	v->hi = i < 0 ? -1 : 0;
+	v->lo = i;
+}
+
+void
+XSyncValueAdd(XSyncValue *r, XSyncValue a, XSyncValue b, int *overflow) {
+	r->lo = a.lo + b.lo;
+	r->hi = a.hi + b.hi + (r->lo < a.lo);
+	*overflow = 0;
+}
+
+Bool
+XSyncValueGreaterOrEqual(XSyncValue a, XSyncValue b) {
+	return a.hi > b.hi || (a.hi == b.hi && a.lo >= b.lo);
+}
+
+unsigned int
+XSyncValueLow32(XSyncValue v) {
+	return v.lo;
+}
+
+int
+XSyncValueHigh32(XSyncValue v) {
+	return v.hi;
+}
+
+/* drw, without fonts; text is 8 pixels per byte */
+Drw *
+drw_create(Display *d, int screen, Window root, unsigned int w, unsigned int h) {
+	Drw *drw = ecalloc(1, sizeof(Drw));
+
+	drw->dpy = d;
+	drw->screen = screen;
+	drw->root = root;
+	drw->w = w;
+	drw->h = h;
+	return drw;
+}
+
+void
+drw_resize(Drw *drw, unsigned int w, unsigned int h) {
+	drw->w = w;
+	drw->h = h;
+}
+
+void
+drw_free(Drw *drw) {
+	free(drw);
+}
+
+Fnt *
+drw_font_create(Display *d, int screen, const char *fontname) {
+	Fnt *font = ecalloc(1, sizeof(Fnt));
+
+	font->h = 16;
+	return font;
+}
+
+void
+drw_font_free(Display *d, Fnt *font) {
+	free(font);
+}
+
+int
+drw_font_guessh(Display *d, int screen, const char *fontname) {
+	return 16;
+}
+
+int
+drw_font_preload(void) {
+	return -1;
+}
+
+void
+drw_font_preload_wait(void) {
+}
+
+void
+drw_font_getexts(Fnt *font, const char *text, unsigned int len, Extnts *extnts) {
+	extnts->w = len * 8;
+	extnts->h = font->h;
+}
+
+unsigned int
+drw_font_getexts_width(Fnt *font, const char *text, unsigned int len) {
+	return len * 8;
+}
+
+Clr *
+drw_clr_create(Drw *drw, const char *clrname) {
+	return ecalloc(1, sizeof(Clr));
+}
+
+void
+drw_clr_free(Clr *clr) {
+	free(clr);
+}
+
+Cur *
+drw_cur_create(Drw *drw, int shape) {
+	return ecalloc(1, sizeof(Cur));
+}
+
+void
+drw_cur_free(Drw *drw, Cur *cursor) {
+	free(cursor);
+}
+
+void
+drw_setfont(Drw *drw, Fnt *font) {
+	drw->font = font;
+}
+
+void
+drw_setscheme(Drw *drw, ClrScheme *scheme) {
+	drw->scheme = scheme;
+}
+
+void
+drw_rect(Drw *drw, int x, int y, int filled, int empty) {
+	if(filled || empty)
+		request("XFillRectangle", False);
+}
+
+void
+drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, const char *text) {
+	request("XFillRectangle", False);
+	if(text && *text)
+		request("pango_xft_render", False);
+}
+
+void
+drw_map(Drw *drw, Window win, int x, int y, unsigned int w, unsigned int h) {
+	request("XCopyArea", False);
+	request("XSync", True);
+}
+
+/* for dwm built with STATS or TRACE; stats.h comes last, its wrappers would
+ * rename the Xlib calls defined above */
+#if defined(STATS) || defined(TRACE)
+#undef ROUNDTRIP
+#include "stats.h"
+
+Stat drwstats[DrwLast] = { /* nothing is rendered, they stay empty */
+	[DrwRender] = { "pango render" },
+	[DrwExtents] = { "pango extents" }
+};
+#endif /* STATS || TRACE */
@@ -0,0 +1,52 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Format of the event captures written by the IPC record request and read by
+ * replay.c. A capture is RECORDMAGIC, a RecordHeader and a sequence of
+ * Records, each followed by len bytes of data. All fields are in host byte
+ * order, X ids are those of the recording server.
+ *
+ * Records carry the X event type dwm received or one of:
+ *	RecAtom      data is the name of atom arg, written before its first use
+ *	RecProperty  a property of win as it was when recording started or the
+ *	             window was first mapped, laid out as for PropertyNotify
+ *	RecIpc       data is a command received on the IPC socket
+ *
+ * Per type, detail, arg, x, y, w, h and data hold:
+ *	KeyPress, KeyRelease        keycode, state
+ *	ButtonPress, ButtonRelease  button, state, x, y on the root window
+ *	MotionNotify, EnterNotify   -, state, x, y on the root window
+ *	MapRequest                  -, -, x, y, w, h of the window
+ *	ConfigureRequest            border, value_mask, x, y, w, h
+ *	UnmapNotify, DestroyNotify  send_event, event window
+ *	ClientMessage               format, message_type, data: 20 bytes,
+ *	                            data.b or data.s for formats 8 and 16, else
+ *	                            5 uint32_t of which only the atoms of
+ *	                            _NET_WM_STATE have their RecAtom
+ *	PropertyNotify, RecProperty state, atom, data: uint32_t type,
+ *	                            uint32_t format, the items, 32 bit items as
+ *	                            uint32_t; no data for properties dwm writes
+ *	                            RecProperty also has x, y, w, h of the window
+ * Other events only carry their window.
+ */
+#include <stdint.h>
+
+#define RECORDMAGIC "dwmrec1\n"
+#define RECORDMAX   4096       /* bytes of data kept per record */
+
+enum { RecAtom = 128, RecProperty, RecIpc };
+
+typedef struct {
+	uint32_t root;             /* root window of the recording */
+	uint16_t sw, sh;           /* screen size */
+} RecordHeader;
+
+typedef struct {
+	uint32_t us;               /* microseconds since the previous record */
+	uint8_t type;
+	uint8_t detail;
+	uint16_t len;              /* bytes of data following */
+	uint32_t win;
+	uint32_t arg;
+	int16_t x, y;
+	uint16_t w, h;
+} Record;
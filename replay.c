@@ -0,0 +1,342 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Replays a capture written by dwm's IPC record request (see record.h)
+ * against a running dwm. Windows of the capture are recreated with their
+ * properties, client requests are sent again, input goes through XTest and
+ * IPC commands through the socket. Records are paced as captured unless -f
+ * is given. Once done, the stats request makes a dwm built with STATS write
+ * its handler times and request counts.
+ *
+ * usage: replay [-f] capture [ipcsocket]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <X11/keysym.h>
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XTest.h>
+
+#include "record.h"
+#include "util.h"
+
+typedef struct {
+	uint32_t from;             /* id in the capture */
+	unsigned long to;          /* id on this server */
+} Map;
+
+/* function declarations */
+static unsigned long atom(uint32_t a);
+static Bool ipc(const char *line, int len);
+static void map(Map **m, unsigned int *n, uint32_t from, unsigned long to);
+static Map *lookup(Map *m, unsigned int n, uint32_t from);
+static void modifiers(unsigned int state, Bool press);
+static double now(void);
+static void replay(Record *r, unsigned char *data);
+static Window window(uint32_t w, Bool create, Record *r);
+static int xerror(Display *dpy, XErrorEvent *ee);
+
+/* variables */
+static Display *dpy;
+static Window root;
+static Atom netwmstate;
+static RecordHeader header;
+static Map *atoms, *wins;
+static unsigned int natoms, nwins;
+static XModifierKeymap *modmap;
+static unsigned int numlockmask;
+static int ipcfd = -1;
+static unsigned long ignored;
+
+/* function implementations */
+unsigned long
+atom(uint32_t a) {
+	Map *m = lookup(atoms, natoms, a);
+
+	return m ? m->to : a; /* predefined atoms keep their values */
+}
+
+/* sends a command line and waits for its ok */
+Bool
+ipc(const char *line, int len) {
+	char buf[512];
+	int n;
+
+	if(write(ipcfd, line, len) != len || write(ipcfd, "\n", 1) != 1)
+		die("replay: ipc write failed\n");
+	for(len = 0; len < (int)sizeof buf - 1; len += n) {
+		if((n = read(ipcfd, buf + len, sizeof buf - 1 - len)) <= 0)
+			die("replay: ipc read failed\n");
+		buf[len + n] = '\0';
+		if(strstr(buf, "ok\n"))
+			return True;
+		if(strstr(buf, "err "))
+			return False;
+	}
+	return False;
+}
+
+void
+map(Map **m, unsigned int *n, uint32_t from, unsigned long to) {
+	if(!(*n % 64) && !(*m = realloc(*m, (*n + 64) * sizeof(Map))))
+		die("fatal: could not realloc() %u bytes\n", (*n + 64) * sizeof(Map));
+	(*m)[*n].from = from;
+	(*m)[(*n)++].to = to;
+}
+
+/* searches from the end, recently created windows are the busy ones */
+Map *
+lookup(Map *m, unsigned int n, uint32_t from) {
+	while(n-- > 0)
+		if(m[n].from == from)
+			return &m[n];
+	return NULL;
+}
+
+/* presses or releases the keys of the modifiers in state, lock keys toggle
+ * and are left alone */
+void
+modifiers(unsigned int state, Bool press) {
+	int i;
+	KeyCode k;
+
+	state &= ~(numlockmask|LockMask);
+	for(i = 0; i < 8; i++)
+		if(state & (1 << i) && (k = modmap->modifiermap[i * modmap->max_keypermod]))
+			XTestFakeKeyEvent(dpy, k, press, CurrentTime);
+}
+
+double
+now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+void
+replay(Record *r, unsigned char *data) {
+	static long items[RECORDMAX / 4];
+	uint32_t *d32 = (uint32_t *)data;
+	unsigned long i, n;
+	Window w;
+	XWindowChanges wc;
+	XEvent ev;
+	Map *m;
+
+	switch(r->type) {
+	case RecAtom:
+		data[r->len] = '\0';
+		map(&atoms, &natoms, r->arg, XInternAtom(dpy, (char *)data, False));
+		break;
+	case RecIpc:
+		if(ipcfd >= 0 && !ipc((char *)data, r->len))
+			ignored++;
+		break;
+	case RecProperty:
+	case PropertyNotify:
+		if(!(w = window(r->win, r->type == RecProperty, r)))
+			break;
+		if(r->detail == PropertyDelete)
+			XDeleteProperty(dpy, w, atom(r->arg));
+		else if(r->len >= 2 * sizeof(uint32_t)
+		     && (d32[1] == 8 || d32[1] == 16 || d32[1] == 32))
+		{
+			n = (r->len - 2 * sizeof(uint32_t)) / (d32[1] == 32 ? 4 : d32[1] / 8);
+			if(d32[1] == 32) {
+				for(i = 0; i < n; i++)
+					items[i] = d32[0] == XA_ATOM ? atom(d32[2 + i])
+					         : d32[0] == XA_WINDOW ? window(d32[2 + i], True, NULL)
+					         : d32[2 + i];
+				data = (unsigned char *)items;
+			}
+			else
+				data += 2 * sizeof(uint32_t);
+			XChangeProperty(dpy, w, atom(r->arg), atom(d32[0]), d32[1],
+			                PropModeReplace, data, n);
+		}
+		break;
+	case MapRequest:
+		XMapWindow(dpy, window(r->win, True, r));
+		break;
+	case ConfigureRequest:
+		wc.x = r->x;
+		wc.y = r->y;
+		wc.width = MAX(r->w, 1);
+		wc.height = MAX(r->h, 1);
+		wc.border_width = r->detail;
+		XConfigureWindow(dpy, window(r->win, True, r),
+		                 r->arg & (CWX|CWY|CWWidth|CWHeight|CWBorderWidth), &wc);
+		break;
+	case UnmapNotify:
+		/* dwm sees each unmap on the root and on the window, act once */
+		if(r->arg != header.root || !(w = window(r->win, False, NULL)))
+			break;
+		if(r->detail) {
+			memset(&ev, 0, sizeof ev);
+			ev.xunmap.type = UnmapNotify;
+			ev.xunmap.event = root;
+			ev.xunmap.window = w;
+			XSendEvent(dpy, root, False, SubstructureRedirectMask|SubstructureNotifyMask, &ev);
+		}
+		else
+			XUnmapWindow(dpy, w);
+		break;
+	case DestroyNotify:
+		if(r->arg != header.root || !(m = lookup(wins, nwins, r->win)))
+			break;
+		XDestroyWindow(dpy, m->to);
+		*m = wins[--nwins];
+		break;
+	case ClientMessage:
+		if(!(w = window(r->win, False, NULL)))
+			break;
+		memset(&ev, 0, sizeof ev);
+		ev.xclient.type = ClientMessage;
+		ev.xclient.window = w;
+		ev.xclient.message_type = atom(r->arg);
+		ev.xclient.format = r->detail;
+		if(r->detail == 32) {
+			for(i = 0; i < 5; i++)
+				ev.xclient.data.l[i] = d32[i];
+			/* the only items known to be atoms, see record.h */
+			if(ev.xclient.message_type == netwmstate) {
+				ev.xclient.data.l[1] = atom(d32[1]);
+				ev.xclient.data.l[2] = atom(d32[2]);
+			}
+		}
+		else
+			memcpy(ev.xclient.data.b, data, sizeof ev.xclient.data.b);
+		XSendEvent(dpy, root, False, SubstructureRedirectMask|SubstructureNotifyMask, &ev);
+		break;
+	case KeyPress:
+		modifiers(r->arg, True);
+		XTestFakeKeyEvent(dpy, r->detail, True, CurrentTime);
+		XTestFakeKeyEvent(dpy, r->detail, False, CurrentTime);
+		modifiers(r->arg, False);
+		break;
+	case ButtonPress:
+		XTestFakeMotionEvent(dpy, -1, r->x, r->y, CurrentTime);
+		modifiers(r->arg, True);
+		XTestFakeButtonEvent(dpy, r->detail, True, CurrentTime);
+		break;
+	case ButtonRelease:
+		XTestFakeButtonEvent(dpy, r->detail, False, CurrentTime);
+		modifiers(r->arg, False);
+		break;
+	case MotionNotify:
+	case EnterNotify:
+		XTestFakeMotionEvent(dpy, -1, r->x, r->y, CurrentTime);
+		break;
+	}
+}
+
+/* Returns the window standing in for w of the capture, creating it with the
+ * geometry of r if asked to. */
+Window
+window(uint32_t w, Bool create, Record *r) {
+	Map *m;
+	Window win;
+
+	if(w == header.root)
+		return root;
+	if((m = lookup(wins, nwins, w)))
+		return m->to;
+	if(!create)
+		return None;
+	win = XCreateSimpleWindow(dpy, root, r ? r->x : 0, r ? r->y : 0,
+	                          r && r->w ? r->w : 1, r && r->h ? r->h : 1, 0, 0, 0);
+	map(&wins, &nwins, w, win);
+	return win;
+}
+
+/* windows of the capture may be gone already, as they were back then */
+int
+xerror(Display *dpy, XErrorEvent *ee) {
+	ignored++;
+	return 0;
+}
+
+int
+main(int argc, char *argv[]) {
+	static uint32_t data[RECORDMAX / 4 + 1];
+	struct sockaddr_un addr;
+	struct timespec ts;
+	char magic[sizeof RECORDMAGIC - 1];
+	double start, due = 0, t;
+	unsigned long n = 0;
+	Bool fast = False;
+	Record r;
+	FILE *f;
+	int d, i, j;
+
+	if(argc > 1 && !strcmp(argv[1], "-f")) {
+		fast = True;
+		argc--, argv++;
+	}
+	if(argc < 2 || argc > 3)
+		die("usage: replay [-f] capture [ipcsocket]\n");
+	if(!(f = fopen(argv[1], "r")) || fread(magic, sizeof magic, 1, f) != 1
+	|| memcmp(magic, RECORDMAGIC, sizeof magic) || fread(&header, sizeof header, 1, f) != 1)
+		die("replay: %s is not a capture\n", argv[1]);
+	if(!(dpy = XOpenDisplay(NULL)))
+		die("replay: cannot open display\n");
+	if(!XTestQueryExtension(dpy, &d, &d, &d, &d))
+		fputs("replay: no XTest, input is not replayed\n", stderr);
+	XSetErrorHandler(xerror);
+	root = DefaultRootWindow(dpy);
+	netwmstate = XInternAtom(dpy, "_NET_WM_STATE", False);
+	modmap = XGetModifierMapping(dpy);
+	for(i = 0; i < 8; i++)
+		for(j = 0; j < modmap->max_keypermod; j++)
+			if(modmap->modifiermap[i * modmap->max_keypermod + j]
+			   == XKeysymToKeycode(dpy, XK_Num_Lock))
+				numlockmask = (1 << i);
+	if(argc == 3) {
+		memset(&addr, 0, sizeof addr);
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, argv[2], sizeof addr.sun_path - 1);
+		if((ipcfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+		|| connect(ipcfd, (struct sockaddr *)&addr, sizeof addr) < 0)
+			die("replay: cannot connect to %s\n", argv[2]);
+	}
+	if(header.sw != DisplayWidth(dpy, DefaultScreen(dpy))
+	|| header.sh != DisplayHeight(dpy, DefaultScreen(dpy)))
+		fprintf(stderr, "replay: captured on a %ux%u screen\n", header.sw, header.sh);
+
+	start = now();
+	while(fread(&r, sizeof r, 1, f) == 1) {
+		if(r.len > RECORDMAX || (r.len && fread(data, r.len, 1, f) != 1))
+			die("replay: %s is truncated\n", argv[1]);
+		if(!fast && (due += r.us / 1e6) > (t = now() - start) + 0.0005) {
+			XFlush(dpy);
+			ts.tv_sec = due - t;
+			ts.tv_nsec = (due - t - ts.tv_sec) * 1e9;
+			nanosleep(&ts, NULL);
+		}
+		replay(&r, (unsigned char *)data);
+		n++;
+	}
+	fclose(f);
+	XSync(dpy, False);
+	t = now() - start;
+	if(ipcfd >= 0) {
+		/* see settle() in bench.c */
+		ipc("monitors", 8);
+		ipc("monitors", 8);
+		t = now() - start;
+		if(!ipc("stats", 5))
+			fputs("replay: dwm has no stats\n", stderr);
+	}
+	printf("{\"records\":%lu,\"ignored\":%lu,\"wall_ms\":%.1f}\n", n, ignored, t * 1000);
+	XFreeModifiermap(modmap);
+	XCloseDisplay(dpy);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,40 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Layout of the state snapshot dwm keeps in statefile (see config.h). The
+ * file is rewritten at the end of each batch of events, guarded by a
+ * sequence counter which is odd while an update is in progress. Readers
+ * mmap the file read-only and copy it out without taking a lock:
+ *
+ *	do {
+ *		while((seq = s->seq) & 1);
+ *		__sync_synchronize();
+ *		memcpy(&copy, s, sizeof copy);
+ *		__sync_synchronize();
+ *	} while(s->seq != seq);
+ *
+ * Readers should check version and size before trusting the rest.
+ */
+#include <stdint.h>
+
+#define STATEVERSION 1
+#define STATEMONS    16
+
+typedef struct {
+	int32_t num;
+	int32_t x, y, w, h;        /* screen size */
+	uint32_t tags;             /* selected tags */
+	uint32_t occ, urg;         /* occupied and urgent tags */
+	uint32_t sel;              /* focused window, 0 if none */
+	uint32_t nclients;
+	char ltsymbol[16];
+} StateMon;
+
+typedef struct {
+	volatile uint32_t seq;
+	uint32_t version;          /* STATEVERSION */
+	uint32_t size;             /* sizeof(State) */
+	uint32_t nmons;            /* entries of mons in use */
+	int32_t selmon;            /* num of the selected monitor */
+	uint32_t pad;
+	StateMon mons[STATEMONS];
+} State;
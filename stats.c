@@ -0,0 +1,102 @@
+/* See LICENSE file for copyright and license details. */
+#include <stdio.h>
+#include <time.h>
+
+#include "stats.h"
+#include "util.h"
+
+typedef struct {
+	const char *name;
+	unsigned long long ts, dur; /* microseconds */
+	unsigned long win, requests;
+	int mon;
+} TraceSpan;
+
+unsigned long stats_roundtrips = 0;
+#ifdef TRACE
+static TraceSpan trace[TRACESIZE];
+static unsigned long ntrace = 0;
+#endif /* TRACE */
+
+void
+stats_begin(StatSpan *sp, unsigned long request, unsigned long win, int mon) {
+	clock_gettime(CLOCK_MONOTONIC, &sp->t);
+	sp->request = request;
+	sp->roundtrips = stats_roundtrips;
+	sp->win = win;
+	sp->mon = mon;
+}
+
+void
+stats_add(Stat *s, unsigned long long us, unsigned long requests, unsigned long roundtrips) {
+	unsigned int b;
+
+	for(b = 0; b < STATBUCKETS - 1 && us >= 1ULL << b; b++);
+	s->hist[b]++;
+	s->n++;
+	s->total += us;
+	if(us > s->max)
+		s->max = us;
+	s->requests += requests;
+	s->roundtrips += roundtrips;
+}
+
+void
+stats_end(Stat *s, const StatSpan *sp, unsigned long request) {
+	struct timespec t;
+	unsigned long long us;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	us = (t.tv_sec - sp->t.tv_sec) * 1000000ULL + t.tv_nsec / 1000 - sp->t.tv_nsec / 1000;
+	stats_add(s, us, request - sp->request, stats_roundtrips - sp->roundtrips);
+#ifdef TRACE
+	{
+		TraceSpan *ts = &trace[ntrace++ % TRACESIZE];
+
+		ts->name = s->name;
+		ts->ts = sp->t.tv_sec * 1000000ULL + sp->t.tv_nsec / 1000;
+		ts->dur = us;
+		ts->win = sp->win;
+		ts->mon = sp->mon;
+		ts->requests = request - sp->request;
+	}
+#endif /* TRACE */
+}
+
+void
+stats_dump(FILE *f, const char *title, const Stat *s, unsigned int n) {
+	unsigned int i, b;
+
+	fprintf(f, "%-18s %8s %10s %8s %8s %8s %8s  histogram <1us <2us <4us ... >=16ms\n",
+	        title, "calls", "total_us", "avg_us", "max_us", "req/call", "rt/call");
+	for(i = 0; i < n; i++) {
+		if(!s[i].name || !s[i].n)
+			continue;
+		fprintf(f, "%-18s %8lu %10llu %8.1f %8llu %8.2f %8.2f ", s[i].name, s[i].n,
+		        s[i].total, (double)s[i].total / s[i].n, s[i].max,
+		        (double)s[i].requests / s[i].n, (double)s[i].roundtrips / s[i].n);
+		for(b = 0; b < STATBUCKETS; b++)
+			fprintf(f, " %lu", s[i].hist[b]);
+		fputc('\n', f);
+	}
+}
+
+/* Writes the spans in the ring, oldest first, as Chrome trace events. */
+void
+stats_trace(FILE *f) {
+#ifdef TRACE
+	unsigned long i;
+	const char *sep = "";
+	TraceSpan *ts;
+
+	fputs("{\"traceEvents\":[", f);
+	for(i = ntrace - MIN(ntrace, TRACESIZE); i < ntrace; i++, sep = ",") {
+		ts = &trace[i % TRACESIZE];
+		fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+		        "\"ts\":%llu,\"dur\":%llu,\"args\":{\"window\":\"0x%lx\","
+		        "\"monitor\":%d,\"requests\":%lu}}", sep,
+		        ts->name, ts->ts, ts->dur, ts->win, ts->mon, ts->requests);
+	}
+	fputs("\n]}\n", f);
+#endif /* TRACE */
+}
@@ -0,0 +1,72 @@
+/* See LICENSE file for copyright and license details.
+ *
+ * Optional instrumentation, compiled in with -DSTATS and/or -DTRACE (see
+ * config.mk). Each Stat accumulates the latency of a code path as a
+ * histogram together with the X requests it issued and the replies it waited
+ * for. With TRACE every span is also kept in a ring buffer which is written
+ * out in the Chrome trace event format, readable by chrome://tracing and
+ * Perfetto. Without either flag the probe macros expand to nothing.
+ */
+#include <stdio.h>
+#include <time.h>
+
+#define STATBUCKETS 16  /* latency buckets, <1us, <2us, <4us, ..., >=16ms */
+#define TRACESIZE   65536 /* spans kept for stats_trace() */
+
+typedef struct {
+	const char *name;
+	unsigned long n;
+	unsigned long requests;    /* X requests issued */
+	unsigned long roundtrips;  /* X replies waited for */
+	unsigned long long total, max; /* microseconds */
+	unsigned long hist[STATBUCKETS];
+} Stat;
+
+typedef struct {
+	struct timespec t;
+	unsigned long request, roundtrips;
+	unsigned long win;         /* window and monitor the span is about */
+	int mon;
+} StatSpan;
+
+enum { DrwRender, DrwExtents, DrwLast }; /* Pango calls in drw.c */
+
+extern Stat drwstats[DrwLast];
+extern unsigned long stats_roundtrips;
+
+void stats_add(Stat *s, unsigned long long us, unsigned long requests, unsigned long roundtrips);
+void stats_begin(StatSpan *sp, unsigned long request, unsigned long win, int mon);
+void stats_end(Stat *s, const StatSpan *sp, unsigned long request);
+void stats_dump(FILE *f, const char *title, const Stat *s, unsigned int n);
+void stats_trace(FILE *f);
+
+#if defined(STATS) || defined(TRACE)
+#define STATSPAN(sp)            StatSpan sp
+#define STATBEGIN(sp, req, win, mon) stats_begin(&(sp), (req), (win), (mon))
+#define STATEND(sp, s, req)     stats_end(&(s), &(sp), (req))
+
+/* count the Xlib calls dwm makes that wait for a reply, include after Xlib */
+#define ROUNDTRIP(call)         (stats_roundtrips++, call)
+#define XGetClassHint(...)      ROUNDTRIP(XGetClassHint(__VA_ARGS__))
+#define XGetModifierMapping(...) ROUNDTRIP(XGetModifierMapping(__VA_ARGS__))
+#define XGetTextProperty(...)   ROUNDTRIP(XGetTextProperty(__VA_ARGS__))
+#define XGetTransientForHint(...) ROUNDTRIP(XGetTransientForHint(__VA_ARGS__))
+#define XGetWindowAttributes(...) ROUNDTRIP(XGetWindowAttributes(__VA_ARGS__))
+#define XGetWindowProperty(...) ROUNDTRIP(XGetWindowProperty(__VA_ARGS__))
+#define XGetWMHints(...)        ROUNDTRIP(XGetWMHints(__VA_ARGS__))
+#define XGetWMNormalHints(...)  ROUNDTRIP(XGetWMNormalHints(__VA_ARGS__))
+#define XGetWMProtocols(...)    ROUNDTRIP(XGetWMProtocols(__VA_ARGS__))
+#define XGrabPointer(...)       ROUNDTRIP(XGrabPointer(__VA_ARGS__))
+#define XInternAtom(...)        ROUNDTRIP(XInternAtom(__VA_ARGS__))
+#define XQueryPointer(...)      ROUNDTRIP(XQueryPointer(__VA_ARGS__))
+#define XQueryTree(...)         ROUNDTRIP(XQueryTree(__VA_ARGS__))
+#define XSync(...)              ROUNDTRIP(XSync(__VA_ARGS__))
+#define XSyncQueryCounter(...)  ROUNDTRIP(XSyncQueryCounter(__VA_ARGS__))
+#define XineramaQueryScreens(...) ROUNDTRIP(XineramaQueryScreens(__VA_ARGS__))
+#define XRRGetCrtcInfo(...)     ROUNDTRIP(XRRGetCrtcInfo(__VA_ARGS__))
+#define XRRGetScreenResourcesCurrent(...) ROUNDTRIP(XRRGetScreenResourcesCurrent(__VA_ARGS__))
+#else
+#define STATSPAN(sp)
+#define STATBEGIN(sp, req, win, mon)
+#define STATEND(sp, s, req)
+#endif /* STATS || TRACE */
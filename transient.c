@@ -1,40 +1,202 @@
-/* cc transient.c -o transient -lX11 */
+/* cc transient.c -o transient -lX11
+ *
+ * Test client and load generator. Maps a swarm of windows from one
+ * connection and keeps changing them at fixed rates:
+ *
+ * transient [-n windows] [-c class] [-s fixed%] [-t transient%] [-d seconds]
+ *           [-T titles/s] [-u urgency/s] [-f fullscreen/s]
+ *           [-C configures/s] [-m maps/s] [-r seed]
+ *
+ * -s and -t give the share of windows with fixed size hints, which dwm
+ * floats, and of windows transient for the window created before them. Each
+ * rate is spread round robin over the windows: -T sets WM_NAME, -u toggles
+ * the urgency hint, -f toggles _NET_WM_STATE_FULLSCREEN, -C asks for a new
+ * geometry and -m unmaps or maps again. Rates are totals per second, a rate
+ * the server cannot keep up with is sent as fast as possible. -d 0 runs
+ * until killed.
+ *
+ * Without options it maps one floating window and, after 5 seconds, a
+ * transient for it.
+ */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/select.h>
+#include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 
-int main(void) {
-	Display *d;
-	Window r, f, t = None;
+enum { Title, Urgency, Fullscreen, Configure, Map, Last };
+
+typedef struct {
+	Window win;
+	int mapped, urgent, fullscreen;
+	unsigned long titles;
+} Swarmwin;
+
+static Display *d;
+static Window r;
+static Swarmwin *w;
+static int n = 1;
+static const char *class = "Swarm";
+
+static double
+now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void
+usage(void) {
+	fputs("usage: transient [-n windows] [-c class] [-s fixed%] [-t transient%]\n"
+	      "                 [-d seconds] [-T titles/s] [-u urgency/s] [-f fullscreen/s]\n"
+	      "                 [-C configures/s] [-m maps/s] [-r seed]\n", stderr);
+	exit(1);
+}
+
+static void
+create(int i, int fixed, int transient) {
 	XSizeHints h;
+	XClassHint ch;
+	char name[32];
+
+	w[i].win = XCreateSimpleWindow(d, r, 50 + i % 50 * 10, 50 + i % 50 * 10,
+	                               fixed ? 400 : 200, fixed ? 400 : 150, 0, 0, 0);
+	if (fixed) {
+		h.min_width = h.max_width = h.min_height = h.max_height = 400;
+		h.flags = PMinSize | PMaxSize;
+		XSetWMNormalHints(d, w[i].win, &h);
+	}
+	if (transient && i > 0)
+		XSetTransientForHint(d, w[i].win, w[i - 1].win);
+	snprintf(name, sizeof name, "swarm%d", i);
+	ch.res_name = name;
+	ch.res_class = (char *)class;
+	XSetClassHint(d, w[i].win, &ch);
+	XStoreName(d, w[i].win, transient && i > 0 ? "transient" : fixed ? "floating" : name);
+	XSelectInput(d, w[i].win, ExposureMask);
+	XMapWindow(d, w[i].win);
+	w[i].mapped = 1;
+}
+
+static void
+act(int a, Swarmwin *s) {
+	static Atom state, fullscreen;
+	XEvent ev;
+	XWMHints wmh;
+	char name[32];
+
+	switch (a) {
+	case Title:
+		snprintf(name, sizeof name, "title %lu", ++s->titles);
+		XStoreName(d, s->win, name);
+		break;
+	case Urgency:
+		/* no other hints are set, no need to read them back */
+		s->urgent = !s->urgent;
+		memset(&wmh, 0, sizeof wmh);
+		wmh.flags = s->urgent ? XUrgencyHint : 0;
+		XSetWMHints(d, s->win, &wmh);
+		break;
+	case Fullscreen:
+		if (!state) {
+			state = XInternAtom(d, "_NET_WM_STATE", False);
+			fullscreen = XInternAtom(d, "_NET_WM_STATE_FULLSCREEN", False);
+		}
+		s->fullscreen = !s->fullscreen;
+		memset(&ev, 0, sizeof ev);
+		ev.xclient.type = ClientMessage;
+		ev.xclient.window = s->win;
+		ev.xclient.message_type = state;
+		ev.xclient.format = 32;
+		ev.xclient.data.l[0] = s->fullscreen; /* _NET_WM_STATE_REMOVE or _ADD */
+		ev.xclient.data.l[1] = fullscreen;
+		XSendEvent(d, r, False, SubstructureNotifyMask | SubstructureRedirectMask, &ev);
+		break;
+	case Configure:
+		XMoveResizeWindow(d, s->win, rand() % 800, rand() % 600,
+		                  100 + rand() % 400, 100 + rand() % 300);
+		break;
+	case Map:
+		if (s->mapped)
+			XUnmapWindow(d, s->win);
+		else
+			XMapWindow(d, s->win);
+		s->mapped = !s->mapped;
+		break;
+	}
+}
+
+int main(int argc, char *argv[]) {
+	double rate[Last] = { 0 }, start, t = 0, duration = 0;
+	unsigned long done[Last] = { 0 }, due;
+	int fixed = 0, transient = 0, idle, i, a;
+	struct timeval tv;
+	fd_set fds;
 	XEvent e;
 
+	if (argc == 1) /* the old test */
+		fixed = transient = 100;
+	else
+		n = 10;
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] != '-' || !argv[i][1] || argv[i][2] || i + 1 == argc)
+			usage();
+		switch (argv[i++][1]) {
+		case 'n': n = atoi(argv[i]); break;
+		case 'c': class = argv[i]; break;
+		case 's': fixed = atoi(argv[i]); break;
+		case 't': transient = atoi(argv[i]); break;
+		case 'd': duration = atof(argv[i]); break;
+		case 'T': rate[Title] = atof(argv[i]); break;
+		case 'u': rate[Urgency] = atof(argv[i]); break;
+		case 'f': rate[Fullscreen] = atof(argv[i]); break;
+		case 'C': rate[Configure] = atof(argv[i]); break;
+		case 'm': rate[Map] = atof(argv[i]); break;
+		case 'r': srand(atoi(argv[i])); break;
+		default: usage();
+		}
+	}
+	if (n < 1 || !(w = calloc(n + (argc == 1), sizeof *w)))
+		usage();
+
 	d = XOpenDisplay(NULL);
 	if (!d)
 		exit(1);
 	r = DefaultRootWindow(d);
 
-	f = XCreateSimpleWindow(d, r, 100, 100, 400, 400, 0, 0, 0);
-	h.min_width = h.max_width = h.min_height = h.max_height = 400;
-	h.flags = PMinSize | PMaxSize;
-	XSetWMNormalHints(d, f, &h);
-	XStoreName(d, f, "floating");
-	XMapWindow(d, f);
-
-	XSelectInput(d, f, ExposureMask);
-	while (1) {
-		XNextEvent(d, &e);
-
-		if (t == None) {
-			sleep(5);
-			t = XCreateSimpleWindow(d, r, 50, 50, 100, 100, 0, 0, 0);
-			XSetTransientForHint(d, t, f);
-			XStoreName(d, t, "transient");
-			XMapWindow(d, t);
-			XSelectInput(d, t, ExposureMask);
-		}
+	for (i = 0; i < n; i++)
+		create(i, i * 100 / n < fixed, i > 0 && i * 100 / n < transient);
+	if (argc == 1) {
+		/* a transient appearing well after its parent */
+		XFlush(d);
+		sleep(5);
+		create(n++, 0, 1);
+	}
+
+	for (idle = 1, a = 0; a < Last; a++)
+		if (rate[a] > 0)
+			idle = 0;
+	start = now();
+	while (!duration || t < duration) {
+		t = now() - start;
+		for (a = 0; a < Last; a++)
+			for (due = rate[a] * t; done[a] < due; done[a]++)
+				act(a, &w[done[a] % n]);
+		XFlush(d);
+		while (XPending(d))
+			XNextEvent(d, &e);
+		/* tick every millisecond, just wait for events when idle */
+		FD_ZERO(&fds);
+		FD_SET(ConnectionNumber(d), &fds);
+		tv.tv_sec = 0;
+		tv.tv_usec = 1000;
+		select(ConnectionNumber(d) + 1, &fds, NULL, NULL, idle && !duration ? NULL : &tv);
 	}
 
 	XCloseDisplay(d);